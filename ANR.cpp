@@ -21,6 +21,13 @@
 #include <iostream>
 using namespace std;
 
+//#define ANR_DEBUG
+#ifdef ANR_DEBUG
+#define LOG(a)	a
+#else
+#define LOG(a)
+#endif
+
 ANR::ANR()
 : m_is_running(false)
 , m_capture_thread("Midingsolo")
@@ -29,14 +36,40 @@ ANR::ANR()
 , m_algo_multicorr(NULL)
 , m_algo_autocorr(NULL)
 , m_algo_bubble(NULL)
+, m_algo_ensemble(NULL)
 , m_algo_current(NULL)
 , m_transform_current(NULL)
+, m_hist_drain("drain")
+, m_hist_algorithm("algorithm")
+, m_hist_quantize("quantize")
+, m_hist_bookkeeping("bookkeeping")
+, m_hist_output("output")
+, m_hist_refresh("refresh")
 #ifdef FANR_OUTPUT_MIDI
 #endif
 {
 //	cerr << "ANR::ANR" << endl;
 
 	m_most_recent_note = 0;
+	m_nb_new_data = 0;
+
+	m_ensemble = false;
+	m_semitone_min = GetSemitoneMin();
+	m_semitone_max = GetSemitoneMax();
+
+	vector<string> levels(NB_BUDGET_LEVELS);
+	levels[BUDGET_FULL] = "full";
+	levels[BUDGET_SINGLE_ALGO] = "single algorithm";
+	levels[BUDGET_COMPLEXITY] = "complexity=1";
+	levels[BUDGET_LATENCY] = "latency=0.5";
+	levels[BUDGET_MIN_COMPLEXITY] = "complexity=0.5";
+	levels[BUDGET_NARROW_RANGE] = "narrow range";
+	m_budget.setLevels(levels);
+
+	m_onset_gating = true;
+	m_note_recognized = false;
+	m_tracking_max_hops = 8;
+	m_nb_tracked_hops = 0;
 
 	m_midi_enabled = true;
 	m_std_enabled = true;
@@ -46,6 +79,16 @@ ANR::ANR()
 	m_notes_history.resize(m_quantizer.getNbChannels());
 
 	m_old_running_time = 0;
+
+	m_refresh_sum = 0.0;
+	m_min_refresh = 1000;
+	m_max_refresh = 0;
+	m_refresh_variation = 0;
+	m_min_used_recon = 1000000;
+	m_min_pending_data = 1000000;
+	m_max_pending_data = 0;
+	m_avg_refresh = 0;
+
 	m_quantizer.addListener(this);
 #ifdef FANR_OUTPUT_MIDI
 	cerr << "ALSA midi client built " << m_midistr.getAlsaMidiID() << ":" << m_midistr.getPort() << endl;
@@ -65,6 +108,7 @@ void ANR::start()
 	m_time.start();
 	m_refresh_time_timer.start();
 	m_is_running = true;
+	m_analysis_thread.startAnalysis();
 	
 //	cerr << "/ANR::start" << endl;
 }
@@ -77,12 +121,13 @@ void ANR::pause(bool toggled)
 	{
 		m_old_running_time = m_time.elapsed();
 		m_is_running = false;
+		// keep the capture connected, but drop the incoming samples
+		m_capture_thread.togglePause(true);
 	}
 	else if(!toggled && !m_is_running)
 	{
-		m_capture_thread.lock();
-		m_capture_thread.m_values.clear();
-		m_capture_thread.unlock();
+		m_capture_thread.togglePause(false);
+		m_capture_thread.clearPendingData();
 
 		m_forgotten_time += m_time.elapsed() - m_old_running_time;
 
@@ -92,15 +137,85 @@ void ANR::pause(bool toggled)
 //	cerr << "/ANR::pause " << toggled << endl;
 }
 
+bool ANR::fillBuffer(int max_nb_data)
+{
+	ScopedTimer timer(m_hist_drain);
+
+	m_captured.clear();
+
+	m_capture_thread.lock();
+
+	int capture_rate = m_capture_thread.getSamplingRate();
+	while(!m_capture_thread.m_values.empty() && (max_nb_data<0 || int(m_captured.size())<max_nb_data))
+	{
+		m_captured.push_back(m_capture_thread.m_values.back());
+		m_capture_thread.m_values.pop_back();
+	}
+
+	m_capture_thread.notifyConsumed();
+	m_capture_thread.unlock();
+
+	if(m_captured.empty())
+		return false;
+
+	// the capture rate changes with the device or the sound file
+	if(capture_rate<=0)
+		capture_rate = GetSamplingRate();
+	if(m_resampler.getInRate()!=capture_rate || m_resampler.getOutRate()!=GetSamplingRate())
+	{
+		cerr << "ANR: INFO: resampling from " << capture_rate << "Hz to " << GetSamplingRate() << "Hz" << endl;
+		m_resampler.setup(capture_rate, GetSamplingRate());
+	}
+
+	m_resampled.clear();
+	m_resampler.process(&m_captured[0], m_captured.size(), m_resampled);
+
+	for(size_t i=0; i<m_resampled.size(); i++)
+		m_queue.push_front(m_resampled[i]);
+	m_nb_new_data += m_resampled.size();
+
+	// keep only what the next recognition can use
+	if(m_algo_current!=NULL)
+	{
+		size_t max_size = max(size_t(2*m_algo_current->getSampleAlgoLatency()), size_t(m_nb_new_data));
+		while(m_queue.size()>max_size)
+			m_queue.pop_back();
+	}
+
+	return true;
+}
+
+void ANR::fillSnapshot(AnalysisSnapshot& snapshot)
+{
+	snapshot.time = getTime();
+	snapshot.note = m_note_recognized?int(m_algo_current->getFondamentalNote()):UNDEFINED_SEMITONE;
+	snapshot.confidence = m_note_recognized?m_algo_current->getConfidence():0.0;
+	snapshot.components.assign(m_transform_current->getComponents().begin(), m_transform_current->getComponents().end());
+	snapshot.semitone_min = GetSemitoneMin();
+
+	snapshot.refresh = m_refresh_time;
+	snapshot.avg_refresh = m_avg_refresh;
+	snapshot.min_pending_data = m_min_pending_data;
+	snapshot.max_pending_data = m_max_pending_data;
+	snapshot.nb_dropped_data = m_capture_thread.getNbDroppedData();
+	snapshot.time_behind = m_capture_thread.getTimeBehind();
+	snapshot.load = m_budget.getLoad();
+	snapshot.budget_level = m_budget.getLevelName();
+}
+
 void ANR::init()
 {
 //	cerr << "ANR::init" << endl;
 
 //	if(GetSamplingRate()<=0)	return;
 
+	// its members are rebuilt
+	if(m_algo_ensemble!=NULL)		delete m_algo_ensemble;
+
 	if(m_algo_multicorr!=NULL)		delete m_algo_multicorr;
 	cerr << "building MultiCorr Algorithm " << flush;
 	m_algo_multicorr = new MultiCorrelationAlgo(1, 2.0);
+	m_algo_multicorr->setTracking(true);
 	cerr << "\tok" << endl;
 
 	if(m_algo_autocorr!=NULL)		delete m_algo_autocorr;
@@ -113,39 +228,151 @@ void ANR::init()
 //	m_algo_bubble = new BubbleAlgo();
 //	cerr << "\tok" << endl;
 
+	cerr << "building Ensemble Algorithm " <<  flush;
+	m_algo_ensemble = new EnsembleAlgo();
+	m_algo_ensemble->add(m_algo_multicorr);
+	m_algo_ensemble->add(m_algo_autocorr, 0.5);
+	cerr << "\tok" << endl;
+
 	m_algo_current = m_algo_multicorr;
 //	m_algo_current = m_algo_bubble;
 	m_transform_current = m_algo_multicorr;
 
+	applyBudgetLevel();
+
 //	cerr << "/ANR::init" << endl;
 }
 
+void ANR::setEnsemble(bool ensemble)
+{
+	m_ensemble = ensemble;
+	applyBudgetLevel();
+}
+
+void ANR::applyBudgetLevel()
+{
+	int level = m_budget.getLevel();
+
+	Algorithm* algo = (m_ensemble && level<BUDGET_SINGLE_ALGO)?(Algorithm*)m_algo_ensemble:(Algorithm*)m_algo_multicorr;
+	if(algo!=m_algo_current)
+	{
+		m_algo_current = algo;
+		m_note_recognized = false;
+		m_nb_tracked_hops = 0;
+	}
+
+	if(m_algo_multicorr!=NULL)
+	{
+		m_algo_multicorr->setTestComplexity((level>=BUDGET_MIN_COMPLEXITY)?0.5:(level>=BUDGET_COMPLEXITY)?1.0:2.0);
+		m_algo_multicorr->setLatencyFactor((level>=BUDGET_LATENCY)?0.5:1.0);
+	}
+
+	// at most 3 octaves in the middle of the instrument range
+	int semitone_min = m_semitone_min;
+	int semitone_max = m_semitone_max;
+	if(level>=BUDGET_NARROW_RANGE && semitone_max-semitone_min>36)
+	{
+		semitone_min = (m_semitone_min+m_semitone_max)/2-18;
+		semitone_max = semitone_min+36;
+	}
+	if(semitone_min!=GetSemitoneMin() || semitone_max!=GetSemitoneMax())
+	{
+		SetSemitoneBounds(semitone_min, semitone_max);
+		m_note_recognized = false;
+	}
+}
+
+void ANR::setInstrumentProfile(const InstrumentProfile& profile)
+{
+	cerr << "instrument profile " << profile.name << " [" << profile.semitone_min << ";" << profile.semitone_max << "]" << endl;
+
+	m_semitone_min = profile.semitone_min;
+	m_semitone_max = profile.semitone_max;
+	applyBudgetLevel();
+
+	if(m_algo_multicorr!=NULL)
+		m_algo_multicorr->setHarmonics(profile.harmonics);
+
+	m_quantizer.setSemitoneBounds(profile.semitone_min, profile.semitone_max);
+	resetNotesHistory();
+}
+
+void ANR::resetNotesHistory()
+{
+	for(size_t ih=0; ih<m_notes_history.size(); ih++)
+		for(size_t i=0; i<m_notes_history[ih].size(); i++)
+			delete m_notes_history[ih][i];
+	m_notes_history.clear();
+	m_notes_tag2descr.clear();
+
+	m_notes_history.resize(m_quantizer.getNbChannels());
+}
+
 void ANR::recognize()
 {
 	m_refresh_time = m_refresh_time_timer.elapsed();
 	m_refresh_time_timer.start();
+	if(Histogram::isEnabled())
+		m_hist_refresh.record(uint64_t(m_refresh_time*1000000));
+
+	Histogram::dumpIfRequested(cerr);
 
-	cerr << "ANR::recognize " << m_refresh_time << ":" << m_nb_new_data << " (" << ((m_queue.empty())?0.0:m_queue[0]) << ")" << endl;
+	LOG(cerr << "ANR::recognize " << m_refresh_time << ":" << m_nb_new_data << " (" << ((m_queue.empty())?0.0:m_queue[0]) << ")" << endl;)
 
 	vector<bool> playing(GetNbSemitones());
 	for(size_t i=0; i<playing.size(); i++)
 		playing[i] = false;
 
-	m_algo_current->apply(m_queue);
+	uint64_t analysis_start = Histogram::now();
+	double hop_time = double(m_nb_new_data)/GetSamplingRate();
+	double analysis_time = 0.0;
 
-	if(getCurrentAlgorithm()->hasNoteRecognized())
-		cerr << m_algo_current->getFondamentalWaveLength() << " " << f2h(GetSamplingRate()/m_algo_current->getFondamentalWaveLength()) << endl;
+	{
+		ScopedTimer timer(m_hist_algorithm);
+
+		// the features of this hop, shared by the onset detector and the algorithm
+		Frame frame(m_queue, max(size_t(2*m_algo_current->getSampleAlgoLatency()), size_t(m_nb_new_data)));
+
+		OnsetDetector::State state = OnsetDetector::ONSET;
+		if(m_onset_gating)
+			state = m_onset_detector.process(frame, m_nb_new_data);
+		m_nb_new_data = 0;
+
+		if(state==OnsetDetector::ONSET)
+			m_algo_current->notifyOnset();
+
+		if(state==OnsetDetector::SILENCE)
+			m_note_recognized = false;
+		else if(state==OnsetDetector::SUSTAIN && m_note_recognized
+				&& m_nb_tracked_hops<m_tracking_max_hops && m_algo_current->track(frame))
+			m_nb_tracked_hops++;
+		else
+		{
+			m_algo_current->apply(frame);
+			m_note_recognized = m_algo_current->hasNoteRecognized();
+			m_nb_tracked_hops = 0;
+		}
+
+		analysis_time = (Histogram::now()-analysis_start)/1e9;
+	}
+
+	LOG(if(m_note_recognized)
+		cerr << m_algo_current->getFondamentalWaveLength() << " " << f2h(GetSamplingRate()/m_algo_current->getFondamentalWaveLength()) << endl;)
 
 	//cerr << "hasNoteRecognized " << getCurrentAlgorithm()->hasNoteRecognized() << " (" << getCurrentAlgorithm()->getFondamentalNote() << ")" << endl;
 
-	if(getCurrentAlgorithm()->hasNoteRecognized())
+	if(m_note_recognized)
 		playing[int(getCurrentAlgorithm()->getFondamentalNote()-GetSemitoneMin())] = true;
 
-	m_quantizer.quantize(playing, GetSemitoneMin());
+	{
+		ScopedTimer timer(m_hist_quantize);
+		m_quantizer.quantize(playing, GetSemitoneMin());
+	}
+
+	ScopedTimer timer(m_hist_bookkeeping);
 
 	// get some real time stats
-	double current_time = getTime();
-	m_recognition_stats.push_front(recon_stat(current_time, m_refresh_time, m_quantizer.getMinStoredRecon(), m_capture_thread.getNbPendingData()));
+	updateRecognitionStats(recon_stat(getTime(), m_refresh_time, m_quantizer.getMinStoredRecon(), m_capture_thread.getNbPendingData()));
 
 	for(size_t i=0; i<playing.size(); i++)
 	{
@@ -165,33 +392,68 @@ void ANR::recognize()
 		}
 	}
 
+	LOG(cerr << "(" << m_quantizer.getMinStoredRecon() << ")" << endl;)
+
+	// last, the analysed range may change
+	if(m_budget.record(analysis_time, hop_time))
+	{
+		cerr << "analysis budget: " << m_budget.getLevelName() << " (load " << m_budget.getLoad() << ")" << endl;
+		applyBudgetLevel();
+	}
+}
+
+void ANR::updateRecognitionStats(const recon_stat& stat)
+{
+	m_recognition_stats.push_front(stat);
+	m_refresh_sum += stat.refresh;
+
 	// keep only one second of stats
-	while(!m_recognition_stats.empty() && current_time-m_recognition_stats.back().time > 1000)
+	// the extremes have to be searched again only if one of them leaves the window
+	bool rescan = false;
+	while(!m_recognition_stats.empty() && stat.time-m_recognition_stats.back().time > 1000)
+	{
+		const recon_stat& old = m_recognition_stats.back();
+		m_refresh_sum -= old.refresh;
+		rescan = rescan
+			|| old.refresh<=m_min_refresh || old.refresh>=m_max_refresh
+			|| old.used_recon<=m_min_used_recon
+			|| old.pending_data<=m_min_pending_data || old.pending_data>=m_max_pending_data;
 		m_recognition_stats.pop_back();
+	}
 
-	cerr << "(" << m_quantizer.getMinStoredRecon() << ")" << endl;
-
-	double min_refresh=1000, max_refresh=0;
-	m_min_used_recon=1000000;
-	m_min_pending_data=1000000;
-	m_max_pending_data=0;
-	m_avg_refresh = 0;
-	for(size_t i=0; i<m_recognition_stats.size(); i++)
+	if(rescan)
+	{
+		m_min_refresh = 1000;
+		m_max_refresh = 0;
+		m_min_used_recon = 1000000;
+		m_min_pending_data = 1000000;
+		m_max_pending_data = 0;
+		for(size_t i=0; i<m_recognition_stats.size(); i++)
+		{
+			m_min_refresh = min(m_min_refresh, m_recognition_stats[i].refresh);
+			m_max_refresh = max(m_max_refresh, m_recognition_stats[i].refresh);
+			m_min_used_recon = min(m_min_used_recon, m_recognition_stats[i].used_recon);
+			m_min_pending_data = min(m_min_pending_data, m_recognition_stats[i].pending_data);
+			m_max_pending_data = max(m_max_pending_data, m_recognition_stats[i].pending_data);
+		}
+	}
+	else
 	{
-		cerr << "(" << m_recognition_stats[i].refresh << " " << m_recognition_stats[i].used_recon << ")" << endl;
-		min_refresh = min(min_refresh, m_recognition_stats[i].refresh);
-		max_refresh = max(max_refresh, m_recognition_stats[i].refresh);
-		m_avg_refresh += int(m_recognition_stats[i].refresh);
-		m_min_used_recon = min(m_min_used_recon, m_recognition_stats[i].used_recon);
-		m_min_pending_data = min(m_min_pending_data, m_recognition_stats[i].pending_data);
-		m_max_pending_data = max(m_max_pending_data, m_recognition_stats[i].pending_data);
+		m_min_refresh = min(m_min_refresh, stat.refresh);
+		m_max_refresh = max(m_max_refresh, stat.refresh);
+		m_min_used_recon = min(m_min_used_recon, stat.used_recon);
+		m_min_pending_data = min(m_min_pending_data, stat.pending_data);
+		m_max_pending_data = max(m_max_pending_data, stat.pending_data);
 	}
-	m_avg_refresh /= m_recognition_stats.size();
-	m_refresh_variation = max_refresh - min_refresh;
+
+	m_avg_refresh = int(m_refresh_sum/m_recognition_stats.size());
+	m_refresh_variation = m_max_refresh - m_min_refresh;
 }
 
 void ANR::noteStarted(int tag, int ht, double dt)
 {
+	ScopedTimer timer(m_hist_output);
+
 	m_most_recent_note = tag;
 
 #ifdef FANR_OUTPUT_MIDI
@@ -218,6 +480,8 @@ void ANR::noteStarted(int tag, int ht, double dt)
 }
 void ANR::noteFinished(int tag, int ht, double dt)
 {
+	ScopedTimer timer(m_hist_output);
+
 #ifdef FANR_OUTPUT_MIDI
 	if(m_midi_enabled)
 		m_midistr << note_off(m_last_note) << drain;
@@ -241,6 +505,8 @@ void ANR::noteFinished(int tag, int ht, double dt)
 }
 void ANR::notePlayed(int ht, double duration, double dt)
 {
+	ScopedTimer timer(m_hist_output);
+
 #ifdef FANR_OUTPUT_STDOUT
 	if(m_std_enabled)
 	{
@@ -256,5 +522,8 @@ void ANR::notePlayed(int ht, double duration, double dt)
 
 ANR::~ANR()
 {
+	m_analysis_thread.stopAnalysis();
+
+	resetNotesHistory();
 }
 
@@ -27,6 +27,7 @@
 #include <map>
 #include <QDateTime>
 #include <CppAddons/Singleton.h>
+#include <CppAddons/Histogram.h>
 #ifdef FANR_OUTPUT_MIDI
 #include <Music/omidistream.h>
 using namespace Music;
@@ -35,10 +36,16 @@ using namespace Music;
 #include <Music/MultiCorrelationAlgo.h>
 #include <Music/AutocorrelationAlgo.h>
 #include <Music/BubbleAlgo.h>
+#include <Music/EnsembleAlgo.h>
 #include <Music/Quantizer.h>
+#include <Music/Resampler.h>
+#include <Music/OnsetDetector.h>
+#include <Music/InstrumentProfile.h>
+#include <Music/BudgetController.h>
 using namespace Music;
 
 #include "CaptureThread.h"
+#include "AnalysisThread.h"
 
 class ANR : public Singleton<ANR>, public QuantizerListener
 {
@@ -63,19 +70,60 @@ class ANR : public Singleton<ANR>, public QuantizerListener
 	deque<double> m_queue;
 	int m_nb_new_data;
 
+	//! from the capture sampling rate to the analysis one (\ref GetSamplingRate)
+	Resampler m_resampler;
+	vector<double> m_captured;
+	vector<double> m_resampled;
+
+	//! runs \ref recognize at each hop
+	AnalysisThread m_analysis_thread;
+	//! move the captured samples to m_queue, true if there were any
+	/*!
+	 * \param max_nb_data at most that many of the oldest samples are moved, all of them if negative
+	 */
+	bool fillBuffer(int max_nb_data=-1);
+	//! the results of the last recognition, from the analysis thread
+	void fillSnapshot(AnalysisSnapshot& snapshot);
+
 	// Algos
 	MultiCorrelationAlgo* m_algo_multicorr;
 	AutocorrelationAlgo* m_algo_autocorr;
 	BubbleAlgo* m_algo_bubble;
+	//! MultiCorr and AutoCorr in parallel, voting
+	EnsembleAlgo* m_algo_ensemble;
 	Algorithm* m_algo_current;
 
 	Transform* m_transform_current;
 
+	//! decide for each refresh if the algorithm has to run, see \ref OnsetDetector
+	OnsetDetector m_onset_detector;
+	bool m_onset_gating;
+	bool m_note_recognized;
+	//! a full detection is forced after this number of tracked hops
+	int m_tracking_max_hops;
+	int m_nb_tracked_hops;
+
 	Algorithm* getCurrentAlgorithm()			{return m_algo_current;}
 	Transform* getCurrentTransform()			{return m_transform_current;}
 
 	// Params
 	void init();
+	//! use the ensemble of the algorithms instead of MultiCorr alone
+	void setEnsemble(bool ensemble);
+	bool isEnsemble()							{return m_ensemble;}
+	//! restrict the analysis and the quantizer to the range of an instrument
+	void setInstrumentProfile(const InstrumentProfile& profile);
+
+	// CPU budget
+	//! the analysis settings, from the best one to the cheapest one
+	enum BudgetLevel{BUDGET_FULL, BUDGET_SINGLE_ALGO, BUDGET_COMPLEXITY, BUDGET_LATENCY, BUDGET_MIN_COMPLEXITY, BUDGET_NARROW_RANGE, NB_BUDGET_LEVELS};
+	//! degrade the analysis settings when it can't keep up with the capture
+	BudgetController m_budget;
+	//! apply the settings of the current level of \ref m_budget
+	void applyBudgetLevel();
+	bool m_ensemble;
+	int m_semitone_min;		//! analysed range of the instrument, without degradation
+	int m_semitone_max;
 
 	double getRefreshTime()				{return (isRunning())?m_refresh_time:0.0;}
 
@@ -97,11 +145,23 @@ class ANR : public Singleton<ANR>, public QuantizerListener
 		recon_stat(double t, double r, int u, int p) : time(t), refresh(r), used_recon(u), pending_data(p) {}
 	};
 	deque<recon_stat> m_recognition_stats;
+	double m_refresh_sum;
+	double m_min_refresh;
+	double m_max_refresh;
 	double m_refresh_variation;
 	int m_min_used_recon;
 	int m_min_pending_data;
 	int m_max_pending_data;
 	int m_avg_refresh;
+	void updateRecognitionStats(const recon_stat& stat);
+
+	// Stage timings (only filled if Histogram::isEnabled())
+	Histogram m_hist_drain;			//! capture thread to m_queue transfer
+	Histogram m_hist_algorithm;		//! Algorithm::apply
+	Histogram m_hist_quantize;		//! Quantizer::quantize (including the output)
+	Histogram m_hist_bookkeeping;	//! notes history and statistics
+	Histogram m_hist_output;		//! midi and standard output of the notes
+	Histogram m_hist_refresh;		//! time between two recognitions
 	
 	Quantizer m_quantizer;
 
@@ -136,6 +196,8 @@ class ANR : public Singleton<ANR>, public QuantizerListener
 	};
 	vector<deque<NoteDescription*> > m_notes_history;
 	map<int,NoteDescription*> m_notes_tag2descr;
+	//! delete the note descriptions, one empty history per quantizer channel
+	void resetNotesHistory();
 
 	// Output
 
@@ -0,0 +1,116 @@
+// Copyright 2005 "Gilles Degottex"
+
+// This file is part of "midingsolo"
+
+// "midingsolo" is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+// 
+// "midingsolo" is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+#include "AnalysisThread.h"
+
+#include <iostream>
+using namespace std;
+#include <CppAddons/RealTime.h>
+#include "ANR.h"
+
+AnalysisSnapshot::AnalysisSnapshot()
+: time(0.0)
+, note(Music::UNDEFINED_SEMITONE)
+, confidence(0.0)
+, semitone_min(0)
+, refresh(0.0)
+, avg_refresh(0)
+, min_pending_data(0)
+, max_pending_data(0)
+, nb_dropped_data(0)
+, time_behind(0.0)
+, load(0.0)
+{
+}
+
+AnalysisThread::AnalysisThread()
+: m_loop(false)
+, m_hop(10)
+, m_rt_priority(0)
+, m_rt_cpu(-1)
+{
+}
+
+void AnalysisThread::startAnalysis()
+{
+	if(isRunning())	return;
+
+	m_loop = true;
+	start();
+}
+
+void AnalysisThread::stopAnalysis()
+{
+	if(!isRunning())	return;
+
+	m_loop = false;
+	anr().m_capture_thread.wakeDataWaiters();
+	wait();
+}
+
+void AnalysisThread::run()
+{
+	string rt_status;
+	if(!RealTime::setup(m_rt_priority, m_rt_cpu, rt_status))
+		cerr << "AnalysisThread: WARNING: " << rt_status << endl;
+
+	cerr << "AnalysisThread: INFO: analysis thread entered (" << rt_status << ")" << endl;
+
+	while(m_loop)
+	{
+		// woken up by the capture as soon as a hop of samples is there (at the capture rate, before resampling)
+		int capture_rate = anr().m_capture_thread.getSamplingRate();
+		if(capture_rate<=0)	capture_rate = Music::GetSamplingRate();
+		int hop = max(1, m_hop*capture_rate/1000);
+		int packet_time = 1000*anr().m_capture_thread.getPacketSize()/max(1, capture_rate);
+		anr().m_capture_thread.waitForData(hop, 2*max(int(m_hop), packet_time));
+		if(!m_loop)	break;
+
+		// offline, the producer fills the buffer while waiting for the analysis, it is not late
+		bool offline = anr().m_capture_thread.isOffline();
+
+		// more than two hops (or packets) behind
+		if(anr().isRunning() && !offline && anr().m_capture_thread.getNbPendingData() > 2*max(hop, anr().m_capture_thread.getPacketSize()))
+			anr().m_capture_thread.reportSchedulingMiss();
+
+		// paused or stopped, the pending samples are dropped (as on resume) so that the next wait blocks
+		if(!anr().isRunning() || !anr().m_capture_thread.isCapturing())
+		{
+			anr().m_capture_thread.clearPendingData();
+			continue;
+		}
+
+		// offline, one recognition per hop until the buffer is empty, otherwise all at once
+		while(m_loop && anr().fillBuffer(offline?hop:-1))
+		{
+			anr().recognize();
+
+			anr().fillSnapshot(m_snapshots.back());
+			m_snapshots.publish();
+
+			if(!offline)	break;
+		}
+	}
+
+	cerr << "AnalysisThread: INFO: analysis thread stopped" << endl;
+}
+
+AnalysisThread::~AnalysisThread()
+{
+	stopAnalysis();
+}
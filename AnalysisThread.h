@@ -0,0 +1,105 @@
+// Copyright 2005 "Gilles Degottex"
+
+// This file is part of "midingsolo"
+
+// "midingsolo" is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+// 
+// "midingsolo" is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+#ifndef _AnalysisThread_h_
+#define _AnalysisThread_h_
+
+#include <vector>
+#include <string>
+#include <atomic>
+using namespace std;
+#include <QtCore/qobject.h>
+#include <QtCore/qthread.h>
+#include <CppAddons/TripleBuffer.h>
+
+//! the results of one recognition, as seen by the GUI
+struct AnalysisSnapshot
+{
+	//! running time of the recognition {millis}
+	double time;
+	//! recognized semi-tone, UNDEFINED_SEMITONE if none
+	int note;
+	double confidence;
+	//! errors of the semi-tones from semitone_min (of the current Transform)
+	vector<double> components;
+	int semitone_min;
+
+	// stats
+	double refresh;
+	int avg_refresh;
+	int min_pending_data;
+	int max_pending_data;
+	//! capture buffer overruns
+	long nb_dropped_data;
+	double time_behind;
+	double load;
+	string budget_level;
+
+	AnalysisSnapshot();
+};
+
+//! run the recognition out of the GUI thread
+/*!
+ * Owns the use of the algorithms and the quantizer of \ref ANR: at each hop
+ * the captured samples are moved to the analysis queue, recognized, and a
+ * snapshot of the results is published.
+ * The GUI reads the latest snapshot without ever blocking, see \ref getSnapshot.
+ * Each hop starts as soon as the capture has a hop of new samples (see
+ * \ref CaptureThread::waitForData). Finding more than two hops pending is
+ * reported as a scheduling miss to the capture thread.
+ */
+class AnalysisThread : public QThread
+{
+	Q_OBJECT
+
+	atomic<bool> m_loop;
+	atomic<int> m_hop;
+
+	int m_rt_priority;
+	int m_rt_cpu;
+
+	TripleBuffer<AnalysisSnapshot> m_snapshots;
+
+	virtual void run();
+
+  public:
+	AnalysisThread();
+
+	//! time between two recognitions {millis}
+	void setHop(int hop)							{m_hop=hop;}
+	int getHop() const								{return m_hop;}
+
+	//! real-time scheduling of the analysis thread, from its next start
+	/*!
+	 * \param priority SCHED_FIFO priority [1;99], 0 for the default scheduling
+	 * \param cpu the cpu the thread is pinned on, -1 for any
+	 */
+	void setRealTime(int priority, int cpu=-1)		{m_rt_priority=priority; m_rt_cpu=cpu;}
+
+	void startAnalysis();
+	//! wait for the current recognition to finish
+	void stopAnalysis();
+
+	//! the latest published results, from one reader thread only (the GUI)
+	const AnalysisSnapshot& getSnapshot()			{m_snapshots.update(); return m_snapshots.front();}
+
+	virtual ~AnalysisThread();
+};
+
+#endif // _AnalysisThread_h_
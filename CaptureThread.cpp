@@ -21,14 +21,25 @@
 
 #include <cassert>
 #include <time.h>
+#include <math.h>
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
 #include <iostream>
 #include <fstream>
 #include <list>
 using namespace std;
 #include <QtCore/qdatetime.h>
+#include <QtCore/qstringlist.h>
+#include <CppAddons/RealTime.h>
 
 CaptureThread::CaptureThread(const QString& name)
 {
@@ -40,8 +51,29 @@ CaptureThread::CaptureThread(const QString& name)
 
 	m_loop = false;
 	m_pause = false;
+	m_packet_size = 0;
+	m_nb_wanted = 1;
+
+	m_capacity = 1<<17;
+	m_overrun_policy = DROP_OLDEST;
+	m_overrun = false;
+	m_overrun_started = false;
+	m_nb_dropped_data = 0;
+	m_high_water_mark = 0;
+	m_time_behind = 0.0;
+	m_nb_underruns = 0;
+	m_nb_pushed = 0;
+	m_offline = false;
+
+	m_rt_priority = 0;
+	m_rt_cpu = -1;
+	m_rt_status = "normal scheduling";
+	m_nb_scheduling_misses = 0;
 
 	m_name = name;
+#ifdef CAPTURE_PIPE
+	m_impls.push_back(new CaptureThreadImplPipe(this));
+#endif
 #ifdef CAPTURE_SOUNDFILE
 	m_impls.push_back(new CaptureThreadImplSoundFile(this));
 #endif
@@ -51,6 +83,9 @@ CaptureThread::CaptureThread(const QString& name)
 #ifdef CAPTURE_ALSA
 	m_impls.push_back(new CaptureThreadImplALSA(this));
 #endif
+#ifdef CAPTURE_RTP
+	m_impls.push_back(new CaptureThreadImplRTP(this));
+#endif
 
 	listTransports();
 }
@@ -166,12 +201,201 @@ void CaptureThread::emitError(const QString& error)
 	emit(errorRaised(error));
 }
 
+QString CaptureThread::getRealTimeStatus()
+{
+	m_lock.lock();
+	QString status = m_rt_status;
+	m_lock.unlock();
+
+	if(m_nb_scheduling_misses>0)
+		status += QString(", %1 scheduling misses").arg(int(m_nb_scheduling_misses));
+
+	return status;
+}
+
+void CaptureThread::reportSchedulingMiss()
+{
+	emit(schedulingMissed(++m_nb_scheduling_misses));
+}
+
 void CaptureThread::emitSamplingRateChanged()
 {
 	if(m_current_impl->m_sampling_rate>0)
 		emit(samplingRateChanged(m_current_impl->m_sampling_rate));
 }
 
+void CaptureThread::setLoop(bool loop)
+{
+	m_state_lock.lock();
+	m_loop = loop;
+	m_state_changed.wakeAll();
+	m_state_lock.unlock();
+}
+
+bool CaptureThread::waitWhileLooping(unsigned long timeout)
+{
+	m_state_lock.lock();
+	if(m_loop)
+		m_state_changed.wait(&m_state_lock, timeout);
+	bool loop = m_loop;
+	m_state_lock.unlock();
+
+	return loop;
+}
+
+bool CaptureThread::waitForData(int n, unsigned long timeout)
+{
+	m_lock.lock();
+	if(int(m_values.size())<n)
+	{
+		m_nb_wanted = n;
+		m_data_added.wait(&m_lock, timeout);
+		m_nb_wanted = 1;
+	}
+	bool ok = int(m_values.size())>=n;
+	bool underrun_now = !ok && m_capturing && !m_pause;
+	if(underrun_now)
+		m_nb_underruns++;
+	long nb_underruns = m_nb_underruns;
+	m_lock.unlock();
+
+	if(underrun_now)
+		emit(underrun(nb_underruns));
+
+	return ok;
+}
+
+int CaptureThread::beginPush(int n, bool can_block)
+{
+	m_lock.lock();
+
+	int policy = m_overrun_policy;
+	m_offline = policy==BLOCK && can_block;
+
+	// more than the whole buffer can hold, the last samples are lost whatever the policy
+	int excess = max(0, n-m_capacity);
+	n -= excess;
+
+	int room = max(0, m_capacity-int(m_values.size()));
+	int dropped = excess;
+	if(n>room && m_offline)
+	{
+		// the wake up may be missed on a stop, hence the timeout
+		while(m_capacity-int(m_values.size())<n && m_loop)
+			m_space_freed.wait(&m_lock, 100);
+		if(!m_loop)
+			return m_nb_pushed = 0;
+	}
+	else if(n>room)
+	{
+		dropped += n-room;
+		if(policy==DROP_NEWEST)
+			n = room;
+		else
+			for(int i=0; i<n-room && !m_values.empty(); i++)
+				m_values.pop_back();
+	}
+
+	if(dropped==0)
+	{
+		m_overrun = false;
+		return m_nb_pushed = n;
+	}
+
+	m_nb_dropped_data += dropped;
+	m_overrun_started = m_overrun_started || !m_overrun;
+	m_overrun = true;
+
+	return m_nb_pushed = n;
+}
+
+void CaptureThread::endPush()
+{
+	int size = int(m_values.size());
+	m_high_water_mark = max(m_high_water_mark, size);
+	if(2*size>m_capacity && getSamplingRate()>0)
+		m_time_behind += double(m_nb_pushed)/getSamplingRate();
+
+	notifyData();
+
+	bool overrun_started = m_overrun_started;
+	m_overrun_started = false;
+	long nb_dropped_data = m_nb_dropped_data;
+
+	m_lock.unlock();
+
+	if(overrun_started)
+	{
+		cerr << "CaptureThread: WARNING: buffer overrun, " << nb_dropped_data << " samples dropped so far" << endl;
+		emit(overrun(nb_dropped_data));
+	}
+}
+
+void CaptureThread::setBufferCapacity(int capacity)
+{
+	m_lock.lock();
+	m_capacity = max(1, capacity);
+	while(int(m_values.size())>m_capacity)
+	{
+		m_values.pop_back();
+		m_nb_dropped_data++;
+	}
+	m_lock.unlock();
+}
+
+long CaptureThread::getNbDroppedData()
+{
+	m_lock.lock();
+	long nb = m_nb_dropped_data;
+	m_lock.unlock();
+	return nb;
+}
+int CaptureThread::getHighWaterMark()
+{
+	m_lock.lock();
+	int nb = m_high_water_mark;
+	m_lock.unlock();
+	return nb;
+}
+double CaptureThread::getTimeBehind()
+{
+	m_lock.lock();
+	double t = m_time_behind;
+	m_lock.unlock();
+	return t;
+}
+long CaptureThread::getNbUnderruns()
+{
+	m_lock.lock();
+	long nb = m_nb_underruns;
+	m_lock.unlock();
+	return nb;
+}
+void CaptureThread::resetBufferStats()
+{
+	m_lock.lock();
+	m_nb_dropped_data = 0;
+	m_high_water_mark = int(m_values.size());
+	m_time_behind = 0.0;
+	m_nb_underruns = 0;
+	m_lock.unlock();
+}
+
+void CaptureThread::clearPendingData()
+{
+	m_lock.lock();
+	m_values.clear();
+	m_space_freed.wakeAll();
+	m_lock.unlock();
+}
+
+void CaptureThread::wakeDataWaiters()
+{
+	m_lock.lock();
+	m_data_added.wakeAll();
+	m_lock.unlock();
+}
+
 void CaptureThread::startCapture()
 {
 	if(m_current_impl==NULL)	return;
@@ -179,16 +403,18 @@ void CaptureThread::startCapture()
 	if(!isRunning())
 		start();
 
-	m_loop = true;
+	setLoop(true);
 }
 void CaptureThread::stopCapture()
 {
 	//	cerr << "CaptureThread::stopCapture" << endl;
 
+	m_state_lock.lock();
 	m_loop = false;
-
+	m_state_changed.wakeAll();
 	while(m_in_run)
-		msleep(10);
+		m_state_changed.wait(&m_state_lock);
+	m_state_lock.unlock();
 
 	//	cerr << "/CaptureThread::stopCapture" << endl;
 }
@@ -271,8 +497,7 @@ CaptureThread::~CaptureThread()
 
 	stopCapture();
 
-	while(isRunning())
-		msleep(10);
+	wait();
 }
 
 void CaptureThread::run()
@@ -281,14 +506,24 @@ void CaptureThread::run()
 
 	while(m_alive)
 	{
+		m_state_lock.lock();
 		while(m_alive && !m_loop)
-			msleep(10);
+			m_state_changed.wait(&m_state_lock);
+		m_in_run = m_alive.load();
+		m_state_lock.unlock();
+
+		if(!m_in_run)	break;
 
-		m_in_run = true;
+		string rt_status;
+		if(!RealTime::setup(m_rt_priority, m_rt_cpu, rt_status))
+			cerr << "CaptureThread: WARNING: " << rt_status << endl;
+		m_lock.lock();
+		m_rt_status = QString(rt_status.c_str());
+		m_lock.unlock();
 
 		try
 		{
-			cerr << "CaptureThread: INFO: capture thread running" << endl;
+			cerr << "CaptureThread: INFO: capture thread running (" << rt_status << ")" << endl;
 
 			m_current_impl->capture_init();
 
@@ -304,14 +539,17 @@ void CaptureThread::run()
 		}
 		catch(QString error)
 		{
-			m_loop = false;
+			setLoop(false);
 //			cerr << "CaptureThread: ERROR: " << error << endl;
 			emit(errorRaised(error));
 		}
 
 		m_current_impl->capture_finished();
 
+		m_state_lock.lock();
 		m_in_run = false;
+		m_state_changed.wakeAll();
+		m_state_lock.unlock();
 
 		cerr << "CaptureThread: INFO: capture thread stop running" << endl;
 	}
@@ -346,6 +584,21 @@ QString CaptureThreadImpl::getStatus()
 
 #define ALSA_BUFF_SIZE 1024
 
+static Music::SampleFormat alsa_sample_format(snd_pcm_format_t format)
+{
+	switch(format)
+	{
+	case SND_PCM_FORMAT_S8:			return Music::SAMPLE_S8;
+	case SND_PCM_FORMAT_U8:			return Music::SAMPLE_U8;
+	case SND_PCM_FORMAT_S16:		return Music::SAMPLE_S16;
+	case SND_PCM_FORMAT_U16:		return Music::SAMPLE_U16;
+	case SND_PCM_FORMAT_S24_3LE:	return Music::SAMPLE_S24_3;
+	case SND_PCM_FORMAT_S32:		return Music::SAMPLE_S32;
+	case SND_PCM_FORMAT_FLOAT:		return Music::SAMPLE_FLOAT;
+	default:						return Music::SAMPLE_UNKNOWN;
+	}
+}
+
 void alsa_error_handler(const char *file, int line, const char *function, int err, const char *fmt, ...)
 {
 	cerr << "alsa_error_handler: " << file << ":" << line << " " << function << " err=" << err << endl;
@@ -358,6 +611,8 @@ CaptureThreadImplALSA::CaptureThreadImplALSA(CaptureThread* capture_thread)
 	m_alsa_hw_params = NULL;
 	m_alsa_buffer = NULL;
 	m_format = SND_PCM_FORMAT_UNKNOWN;
+	m_channel_count = 1;
+	m_converter = NULL;
 
 	m_source = "hw:0";
 
@@ -439,8 +694,10 @@ void CaptureThreadImplALSA::set_params()
 	if(m_format==-1)
 	{
 		list<snd_pcm_format_t> formats;
-		formats.push_back(SND_PCM_FORMAT_S16);	formats.push_back(SND_PCM_FORMAT_U16);
-		formats.push_back(SND_PCM_FORMAT_S8);	formats.push_back(SND_PCM_FORMAT_U8);
+		formats.push_back(SND_PCM_FORMAT_S16);	formats.push_back(SND_PCM_FORMAT_S32);
+		formats.push_back(SND_PCM_FORMAT_S24_3LE);	formats.push_back(SND_PCM_FORMAT_FLOAT);
+		formats.push_back(SND_PCM_FORMAT_U16);	formats.push_back(SND_PCM_FORMAT_S8);
+		formats.push_back(SND_PCM_FORMAT_U8);
 
 		err = -1;
 		while(err<0)
@@ -460,6 +717,9 @@ void CaptureThreadImplALSA::set_params()
 	}
 	else
 	{
+		if(alsa_sample_format(m_format)==Music::SAMPLE_UNKNOWN)
+			throw QString("ALSA: unsupported format ")+snd_pcm_format_description(m_format);
+
 		if((err=snd_pcm_hw_params_set_format(m_alsa_capture_handle, m_alsa_hw_params, m_format))<0)
 		{
 			QString err_msg = QString("ALSA: cannot set format (")+QString(snd_strerror(err))+")";
@@ -467,16 +727,17 @@ void CaptureThreadImplALSA::set_params()
 		}
 	}
 
-	// Channel count
-	unsigned int channel_count = 1;
-	if((err=snd_pcm_hw_params_set_channels_near(m_alsa_capture_handle, m_alsa_hw_params, &channel_count)) < 0)
+	// Channel count, the channels are mixed down to mono
+	m_channel_count = 1;
+	if((err=snd_pcm_hw_params_set_channels_near(m_alsa_capture_handle, m_alsa_hw_params, &m_channel_count)) < 0)
 	{
 		QString err_msg = QString("ALSA: cannot set channel count (")+QString(snd_strerror(err))+")";
 		cerr << "CaptureThread: ERROR: " << err_msg.toStdString() << endl;
+		m_channel_count = 1;
 	}
 
-	if(channel_count!=1)
-		cerr << "CaptureThread: ERROR: ALSA: channel count is not set to one !" << endl;
+	if(m_channel_count!=1)
+		cerr << "CaptureThread: INFO: ALSA: " << m_channel_count << " channels, mixed down to mono" << endl;
 
 	if(m_sampling_rate==CaptureThread::SAMPLING_RATE_MAX)
 	{
@@ -559,7 +820,10 @@ void CaptureThreadImplALSA::capture_init()
 
 	snd_pcm_nonblock(m_alsa_capture_handle, 0);
 
-	m_alsa_buffer = new signed short[ALSA_BUFF_SIZE];
+	Music::SampleFormat format = alsa_sample_format(m_format);
+	m_converter = Music::GetSampleConverter(format, m_channel_count);
+	m_alsa_buffer = new unsigned char[ALSA_BUFF_SIZE*m_channel_count*Music::GetSampleSize(format)];
+	m_converted.resize(ALSA_BUFF_SIZE);
 
 	int err=0;
 
@@ -568,20 +832,18 @@ void CaptureThreadImplALSA::capture_init()
 }
 void CaptureThreadImplALSA::capture_loop()
 {
-	double value;
-
-	int format_size = snd_pcm_format_width(m_format) / 8;
-	bool format_signed = snd_pcm_format_signed(m_format);
-
 	while(m_capture_thread->m_loop)
 	{
 		int ret_val = snd_pcm_readi(m_alsa_capture_handle, m_alsa_buffer, ALSA_BUFF_SIZE);
 		if(ret_val<0)
 		{
 			cerr << "CaptureThread: WARNING: ALSA: " << snd_strerror(ret_val) << endl;
+			if(ret_val==-EPIPE)
+				m_capture_thread->reportSchedulingMiss();
 			while((ret_val = snd_pcm_prepare(m_alsa_capture_handle)) < 0)
 			{
-				m_capture_thread->msleep(1000);
+				if(!m_capture_thread->waitWhileLooping(1000))
+					return;
 				cerr << QString("ALSA: cannot prepare audio interface (").toStdString()+QString(snd_strerror(ret_val)).toStdString()+")" << endl;
 //				throw QString("ALSA: cannot prepare audio interface (")+QString(snd_strerror(ret_val))+")";
 			}
@@ -590,26 +852,16 @@ void CaptureThreadImplALSA::capture_loop()
 		{
 			if(!m_capture_thread->m_pause)
 			{
-				m_capture_thread->m_lock.lock();
-
-				for(int i=0; i<ret_val; i++)
-				{
-					if(format_size==2)
-					{
-						if(format_signed)	value = (signed short)(m_alsa_buffer[i])/32768.0;
-						else				value = 2*(unsigned short)(m_alsa_buffer[i])/65536.0 - 1;
-					}
-					else
-					{
-						if(format_signed)	value = (signed char)(m_alsa_buffer[i])/128.0;
-						else				value = 2*(unsigned char)(m_alsa_buffer[i])/256.0 - 1;
-					}
-					m_capture_thread->m_values.push_front(value);
-				}
-
-				m_capture_thread->m_lock.unlock();
-
 				m_capture_thread->m_packet_size = ret_val;
+
+				// converted before locking m_values
+				m_converter(m_alsa_buffer, ret_val, m_channel_count, &m_converted[0]);
+
+				int n = m_capture_thread->beginPush(ret_val);
+				for(int i=0; i<n; i++)
+					m_capture_thread->m_values.push_front(m_converted[i]);
+
+				m_capture_thread->endPush();
 			}
 		}
 	}
@@ -618,7 +870,7 @@ void CaptureThreadImplALSA::capture_finished()
 {
 	if(m_alsa_buffer!=NULL)
 	{
-		delete m_alsa_buffer;
+		delete[] m_alsa_buffer;
 		m_alsa_buffer = NULL;
 	}
 
@@ -693,7 +945,7 @@ void CaptureThreadImplJACK::jackShutdown()
 
 	m_capture_thread->emitError("JACK: server shutdown !");
 
-	m_capture_thread->m_loop = false;
+	m_capture_thread->setLoop(false);
 }
 
 int CaptureThreadImplJACK::JackSampleRate(jack_nframes_t nframes, void* arg){return ((CaptureThreadImplJACK*)arg)->jackSampleRate(nframes);}
@@ -720,14 +972,14 @@ int CaptureThreadImplJACK::jackProcess(jack_nframes_t nframes)
 
 	jack_default_audio_sample_t* in = (jack_default_audio_sample_t*) jack_port_get_buffer(m_jack_port, nframes);
 
-	m_capture_thread->m_lock.lock();
+	m_capture_thread->m_packet_size = nframes;
 
-	for(jack_nframes_t i=0; i<nframes; i++)
-		m_capture_thread->m_values.push_front(in[i]);
+	int n = m_capture_thread->beginPush(nframes);
 
-	m_capture_thread->m_lock.unlock();
+	for(int i=0; i<n; i++)
+		m_capture_thread->m_values.push_front(in[i]);
 
-	m_capture_thread->m_packet_size = nframes;
+	m_capture_thread->endPush();
 
 	//	if(g_count)		g_frames += nframes;
 
@@ -765,19 +1017,8 @@ void CaptureThreadImplJACK::capture_loop()
 	//	time.start();
 	//	int t = 0;
 
-	while(m_capture_thread->m_loop)
-	{
-		//		if(!g_count && time.elapsed()>=3000)
-		//		{
-		//			t = time.elapsed();
-		//			g_count = true;
-		//		}
-		//		if(g_count)
-		//		{
-		//			cerr << 1000.0*g_frames/float(time.elapsed()-t) << endl;
-		//		}
-		m_capture_thread->msleep(33);
-	}
+	// the samples come from the JACK thread, only wait for the stop
+	m_capture_thread->waitWhileLooping();
 }
 void CaptureThreadImplJACK::capture_finished()
 {
@@ -851,16 +1092,18 @@ void CaptureThreadImplSoundFile::capture_loop()
 		//cerr << "sampling_rate " << m_sampling_rate << " sleep " << sleep << endl;
 
 		m_capture_thread->usleep(sleep);
-		m_capture_thread->m_lock.lock();
 
 		int frames = sf_read_short(m_file, &sample[0], buf_size);
 		//sample /= 32768.0;
 		//cerr << "sample " << sample << endl;
-		for (int i = 0; i < buf_size; i++) {
+
+		// offline, the file can wait for the analysis
+		int n = m_capture_thread->beginPush(buf_size, true);
+		for (int i = 0; i < n; i++) {
 			m_capture_thread->m_values.push_front(sample[i]);
 		}
 
-		m_capture_thread->m_lock.unlock();
+		m_capture_thread->endPush();
 
 		//m_capture_thread->m_packet_size = frames;
 
@@ -877,3 +1120,482 @@ void CaptureThreadImplSoundFile::capture_finished()
 }
 
 #endif
+
+// ------------------------------ raw PCM transports ----------------------------
+
+#if defined(CAPTURE_PIPE) || defined(CAPTURE_RTP)
+
+CaptureThreadImplRawPCM::CaptureThreadImplRawPCM(CaptureThread* capture_thread, const QString& name, const QString& descr, Music::SampleFormat format)
+: CaptureThreadImpl(capture_thread, name, descr)
+{
+	m_format = format;
+	m_channel_count = 1;
+	m_sampling_rate = 44100;
+}
+
+void CaptureThreadImplRawPCM::parse_format(const QStringList& fields, int first, Music::SampleFormat default_format)
+{
+	int f = first;
+
+	m_format = default_format;
+	if(f<int(fields.size()) && fields[f]!="")
+	{
+		m_format = Music::FindSampleFormat(fields[f].toStdString());
+		if(m_format==Music::SAMPLE_UNKNOWN)
+			throw m_name+": unknown format '"+fields[f]+"'";
+	}
+	f++;
+
+	if(f<int(fields.size()) && fields[f]!="")
+	{
+		int rate = fields[f].toInt();
+		if(rate<=0)
+			throw m_name+": invalid sampling rate '"+fields[f]+"'";
+		m_sampling_rate = rate;
+	}
+	f++;
+
+	m_channel_count = 1;
+	if(f<int(fields.size()) && fields[f]!="")
+	{
+		m_channel_count = fields[f].toInt();
+		if(m_channel_count<=0)
+			throw m_name+": invalid channel count '"+fields[f]+"'";
+	}
+}
+
+void CaptureThreadImplRawPCM::setSamplingRate(int value)
+{
+	// the rate is the one of the incoming stream, it can only be declared
+	if(value>0 && value!=m_sampling_rate)
+	{
+		m_sampling_rate = value;
+		m_capture_thread->emitSamplingRateChanged();
+	}
+}
+
+#endif
+
+// ------------------------------ raw PCM pipe implementation ----------------------------
+
+#ifdef CAPTURE_PIPE
+
+#define PIPE_BUFF_SIZE 4096
+
+CaptureThreadImplPipe::CaptureThreadImplPipe(CaptureThread* capture_thread)
+: CaptureThreadImplRawPCM(capture_thread, "PIPE", "raw PCM from stdin or a named pipe", Music::SAMPLE_S16)
+{
+	m_offline = false;
+
+	m_fd = -1;
+	m_fifo = false;
+	m_converter = NULL;
+	m_buffer_size = 0;
+
+	m_source = "-";
+}
+
+void CaptureThreadImplPipe::parse_source()
+{
+	QStringList fields = m_source.split(':');
+
+	m_path = fields[0];
+	if(m_path=="")
+		m_path = "-";
+
+	parse_format(fields, 1, Music::SAMPLE_S16);
+
+	m_offline = fields.size()>4 && fields[4]=="offline";
+}
+
+bool CaptureThreadImplPipe::is_available()
+{
+	QString path = m_source.section(':', 0, 0);
+
+	struct stat st;
+	if(path=="" || path=="-")
+	{
+		// not auto detected when stdin is the terminal
+		if(isatty(STDIN_FILENO) || fstat(STDIN_FILENO, &st)!=0 || !(S_ISFIFO(st.st_mode) || S_ISREG(st.st_mode)))
+		{
+			m_status = "unavailable (stdin is not a pipe)";
+			return false;
+		}
+	}
+	else if(stat(path.toLatin1(), &st)!=0 || !(S_ISFIFO(st.st_mode) || S_ISREG(st.st_mode)))
+	{
+		m_status = "unavailable (no pipe '"+path+"')";
+		return false;
+	}
+
+	m_status = "available";
+
+	cerr << "CaptureThread: INFO: PIPE seems available" << endl;
+
+	return true;
+}
+
+void CaptureThreadImplPipe::open_input()
+{
+	// stdin is left as it is, its flags are shared with the shell and the other
+	// readers, the loop only reads after poll anyway
+	if(m_path=="-")
+		m_fd = STDIN_FILENO;
+	// non blocking, so a named pipe without writer doesn't block the opening
+	else if((m_fd=open(m_path.toLatin1(), O_RDONLY | O_NONBLOCK))<0)
+		throw QString("PIPE: cannot open '")+m_path+"' ("+strerror(errno)+")";
+
+	struct stat st;
+	m_fifo = fstat(m_fd, &st)==0 && S_ISFIFO(st.st_mode);
+	if(fstat(m_fd, &st)==0 && S_ISREG(st.st_mode))
+		m_offline = true;
+}
+
+void CaptureThreadImplPipe::close_input()
+{
+	if(m_fd>=0 && m_fd!=STDIN_FILENO)
+		close(m_fd);
+	m_fd = -1;
+}
+
+void CaptureThreadImplPipe::capture_init()
+{
+	int old_sampling_rate = m_sampling_rate;
+
+	parse_source();
+	open_input();
+
+	m_converter = Music::GetSampleConverter(m_format, m_channel_count);
+	m_buffer.resize(PIPE_BUFF_SIZE*m_channel_count*Music::GetSampleSize(m_format));
+	m_buffer_size = 0;
+	m_converted.resize(PIPE_BUFF_SIZE);
+
+	if(m_offline && m_capture_thread->getOverrunPolicy()!=CaptureThread::BLOCK)
+	{
+		cerr << "CaptureThread: INFO: PIPE: offline, the capture waits for the analysis" << endl;
+		m_capture_thread->setOverrunPolicy(CaptureThread::BLOCK);
+	}
+
+	cerr << "CaptureThread: INFO: PIPE: " << m_path.toStdString() << " " << Music::GetSampleFormatName(m_format)
+		<< " " << m_sampling_rate << "Hz " << m_channel_count << " channel(s)" << (m_offline?" offline":"") << endl;
+
+	if(m_sampling_rate!=old_sampling_rate)
+		m_capture_thread->emitSamplingRateChanged();
+}
+
+void CaptureThreadImplPipe::capture_loop()
+{
+	size_t frame_size = m_channel_count*Music::GetSampleSize(m_format);
+
+	while(m_capture_thread->m_loop)
+	{
+		// wait for the input only, waking up regularly to check m_loop
+		struct pollfd pfd;
+		pfd.fd = m_fd;
+		pfd.events = POLLIN;
+		pfd.revents = 0;
+		if(poll(&pfd, 1, 100)<0)
+		{
+			if(errno==EINTR)	continue;
+			throw QString("PIPE: poll failed (")+strerror(errno)+")";
+		}
+		if(pfd.revents==0)
+			continue;
+
+		ssize_t ret_val = read(m_fd, &m_buffer[m_buffer_size], m_buffer.size()-m_buffer_size);
+		if(ret_val<0)
+		{
+			if(errno==EAGAIN || errno==EINTR)	continue;
+			throw QString("PIPE: read failed (")+strerror(errno)+")";
+		}
+		if(ret_val==0)
+		{
+			// a named pipe waits for the next writer, the other inputs are over
+			if(m_fifo && m_path!="-")
+			{
+				cerr << "CaptureThread: INFO: PIPE: writer closed, waiting for the next one" << endl;
+				close_input();
+				open_input();
+				m_buffer_size = 0;
+				// without writer, the reopened pipe is silent until one connects
+				continue;
+			}
+
+			cerr << "CaptureThread: INFO: PIPE: end of input" << endl;
+			m_capture_thread->setLoop(false);
+			return;
+		}
+		m_buffer_size += ret_val;
+
+		// whole frames only, the remaining bytes wait for the next read
+		int nb_frames = m_buffer_size/frame_size;
+		if(nb_frames==0)
+			continue;
+
+		if(!m_capture_thread->m_pause)
+		{
+			m_capture_thread->m_packet_size = nb_frames;
+
+			m_converter(&m_buffer[0], nb_frames, m_channel_count, &m_converted[0]);
+
+			int n = m_capture_thread->beginPush(nb_frames, m_offline);
+			for(int i=0; i<n; i++)
+				m_capture_thread->m_values.push_front(m_converted[i]);
+
+			m_capture_thread->endPush();
+		}
+
+		size_t used = nb_frames*frame_size;
+		memmove(&m_buffer[0], &m_buffer[used], m_buffer_size-used);
+		m_buffer_size -= used;
+	}
+}
+
+void CaptureThreadImplPipe::capture_finished()
+{
+	close_input();
+}
+
+#endif
+
+// ------------------------------ RTP implementation ----------------------------
+
+#ifdef CAPTURE_RTP
+
+#define RTP_HEADER_SIZE 12
+#define RTP_MAX_PACKET_SIZE 65536
+
+static double monotonic_time()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + 1e-9*ts.tv_nsec;
+}
+
+CaptureThreadImplRTP::CaptureThreadImplRTP(CaptureThread* capture_thread)
+: CaptureThreadImplRawPCM(capture_thread, "RTP", "uncompressed PCM over RTP/UDP", Music::SAMPLE_S16_BE)
+{
+	m_address = "127.0.0.1";
+	m_port = 5004;
+
+	m_socket = -1;
+	m_has_ssrc = false;
+	m_ssrc = 0;
+	m_last_packet_time = 0.0;
+	m_payload_type = -1;
+	m_converter = NULL;
+	m_nb_invalid = 0;
+	m_nb_foreign = 0;
+
+	m_source = "127.0.0.1:5004";
+}
+
+void CaptureThreadImplRTP::parse_source()
+{
+	QStringList fields = m_source.split(':');
+
+	// the address is optional
+	int f = 0;
+	bool numeric = false;
+	fields[0].toInt(&numeric);
+	if(!numeric)
+		m_address = fields[f++];
+	if(f>=int(fields.size()) || fields[f].toInt()<=0 || fields[f].toInt()>65535)
+		throw QString("RTP: invalid port in '")+m_source+"'";
+	m_port = fields[f++].toInt();
+
+	parse_format(fields, f, Music::SAMPLE_S16_BE);
+}
+
+bool CaptureThreadImplRTP::is_available()
+{
+	int s = socket(AF_INET, SOCK_DGRAM, 0);
+	if(s<0)
+	{
+		m_status = QString("unavailable (")+strerror(errno)+")";
+		return false;
+	}
+	close(s);
+
+	m_status = "available";
+
+	cerr << "CaptureThread: INFO: RTP seems available" << endl;
+
+	return true;
+}
+
+void CaptureThreadImplRTP::capture_init()
+{
+	int old_sampling_rate = m_sampling_rate;
+
+	parse_source();
+
+	if((m_socket=socket(AF_INET, SOCK_DGRAM, 0))<0)
+		throw QString("RTP: cannot create the socket (")+strerror(errno)+")";
+
+	// the default receive buffer is too small for the bursts
+	int size = 1<<20;
+	setsockopt(m_socket, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+
+	struct sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(m_port);
+	if(inet_aton(m_address.toLatin1(), &addr.sin_addr)==0)
+		throw QString("RTP: invalid address '")+m_address+"'";
+	if(bind(m_socket, (struct sockaddr*)&addr, sizeof(addr))<0)
+		throw QString("RTP: cannot bind ")+m_address+":"+QString::number(m_port)+" ("+strerror(errno)+")";
+
+	m_packet.resize(RTP_MAX_PACKET_SIZE);
+	m_has_ssrc = false;
+	m_payload_type = -1;
+	m_converter = Music::GetSampleConverter(m_format, m_channel_count);
+	m_jitter_buffer.reset();
+	m_jitter_buffer.resetStats();
+	m_nb_invalid = 0;
+	m_nb_foreign = 0;
+
+	cerr << "CaptureThread: INFO: RTP: listening on " << m_address.toStdString() << ":" << m_port << " "
+		<< Music::GetSampleFormatName(m_format) << " " << m_sampling_rate << "Hz " << m_channel_count << " channel(s)" << endl;
+
+	if(m_sampling_rate!=old_sampling_rate)
+		m_capture_thread->emitSamplingRateChanged();
+}
+
+void CaptureThreadImplRTP::set_payload(int payload_type)
+{
+	if(payload_type==m_payload_type)
+		return;
+	m_payload_type = payload_type;
+
+	// RFC 3551 static payload types, the dynamic ones are configured
+	int old_sampling_rate = m_sampling_rate;
+	if(payload_type==10 || payload_type==11)
+	{
+		m_format = Music::SAMPLE_S16_BE;
+		m_channel_count = (payload_type==10)?2:1;
+		m_sampling_rate = 44100;
+	}
+	else
+		parse_source();
+
+	m_converter = Music::GetSampleConverter(m_format, m_channel_count);
+
+	cerr << "CaptureThread: INFO: RTP: payload type " << payload_type << ", " << Music::GetSampleFormatName(m_format)
+		<< " " << m_sampling_rate << "Hz " << m_channel_count << " channel(s)" << endl;
+
+	if(m_sampling_rate!=old_sampling_rate)
+		m_capture_thread->emitSamplingRateChanged();
+}
+
+void CaptureThreadImplRTP::receive_packet(size_t size, double now)
+{
+	const unsigned char* p = &m_packet[0];
+
+	// RFC 3550 fixed header
+	if(size<RTP_HEADER_SIZE || (p[0]>>6)!=2)
+	{
+		m_nb_invalid++;
+		return;
+	}
+	int payload_type = p[1]&0x7f;
+	uint16_t seq = uint16_t(p[2])<<8 | p[3];
+	uint32_t timestamp = uint32_t(p[4])<<24 | uint32_t(p[5])<<16 | uint32_t(p[6])<<8 | p[7];
+	uint32_t ssrc = uint32_t(p[8])<<24 | uint32_t(p[9])<<16 | uint32_t(p[10])<<8 | p[11];
+
+	size_t begin = RTP_HEADER_SIZE + 4*(p[0]&0x0f);		// CSRC list
+	if((p[0]&0x10) && begin+4<=size)					// header extension
+		begin += 4 + 4*(size_t(p[begin+2])<<8 | p[begin+3]);
+	size_t end = size;
+	if(p[0]&0x20)										// padding
+		end -= min(size, size_t(p[size-1]));
+	if(begin>end || !(payload_type==10 || payload_type==11 || (payload_type>=96 && payload_type<=127)))
+	{
+		m_nb_invalid++;
+		return;
+	}
+
+	// follow a single stream
+	if(!m_has_ssrc || (ssrc!=m_ssrc && now-m_last_packet_time>2.0))
+	{
+		if(m_has_ssrc)
+			cerr << "CaptureThread: INFO: RTP: new stream " << hex << ssrc << dec << endl;
+		m_has_ssrc = true;
+		m_ssrc = ssrc;
+		m_jitter_buffer.reset();
+	}
+	else if(ssrc!=m_ssrc)
+	{
+		m_nb_foreign++;
+		return;
+	}
+	m_last_packet_time = now;
+
+	set_payload(payload_type);
+
+	size_t nb_frames = (end-begin)/(m_channel_count*Music::GetSampleSize(m_format));
+	if(m_converted.size()<nb_frames)
+		m_converted.resize(nb_frames);
+	m_converter(p+begin, nb_frames, m_channel_count, &m_converted[0]);
+
+	m_jitter_buffer.insert(seq, timestamp, &m_converted[0], nb_frames, now);
+}
+
+void CaptureThreadImplRTP::capture_loop()
+{
+	while(m_capture_thread->m_loop)
+	{
+		// wait for the packets, or for the deadline of a missing one
+		int timeout = 100;
+		double jitter_timeout = m_jitter_buffer.getTimeout(monotonic_time());
+		if(jitter_timeout>=0.0)
+			timeout = min(timeout, int(ceil(1000*jitter_timeout)));
+
+		struct pollfd pfd;
+		pfd.fd = m_socket;
+		pfd.events = POLLIN;
+		pfd.revents = 0;
+		if(poll(&pfd, 1, timeout)<0 && errno!=EINTR)
+			throw QString("RTP: poll failed (")+strerror(errno)+")";
+
+		double now = monotonic_time();
+
+		// all the pending packets at once
+		ssize_t ret_val;
+		while((ret_val=recv(m_socket, &m_packet[0], m_packet.size(), MSG_DONTWAIT))>=0)
+			receive_packet(ret_val, now);
+		if(errno!=EAGAIN && errno!=EWOULDBLOCK && errno!=EINTR)
+			throw QString("RTP: receive failed (")+strerror(errno)+")";
+
+		m_pulled.clear();
+		m_jitter_buffer.pull(m_pulled, now);
+
+		if(!m_pulled.empty() && !m_capture_thread->m_pause)
+		{
+			m_capture_thread->m_packet_size = m_pulled.size();
+
+			int n = m_capture_thread->beginPush(m_pulled.size());
+			for(int i=0; i<n; i++)
+				m_capture_thread->m_values.push_front(m_pulled[i]);
+
+			m_capture_thread->endPush();
+		}
+	}
+}
+
+void CaptureThreadImplRTP::capture_finished()
+{
+	if(m_socket>=0)
+	{
+		close(m_socket);
+		m_socket = -1;
+
+		const Music::JitterBuffer::Stats& stats = m_jitter_buffer.getStats();
+		cerr << "CaptureThread: INFO: RTP: " << stats.received << " packets received, " << stats.lost << " lost ("
+			<< stats.concealed << " samples concealed), " << stats.late << " late, " << stats.duplicated << " duplicated, "
+			<< stats.reordered << " reordered, " << stats.resyncs << " resyncs, " << m_nb_invalid << " invalid, "
+			<< m_nb_foreign << " from other streams" << endl;
+	}
+}
+
+#endif
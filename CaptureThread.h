@@ -22,10 +22,17 @@
 
 #include <deque>
 #include <list>
+#include <vector>
+#include <atomic>
+#include <limits.h>
 using namespace std;
 #include <QtCore/qobject.h>
 #include <QtCore/qthread.h>
 #include <QtCore/qmutex.h>
+#include <QtCore/qwaitcondition.h>
+#include <QtCore/qstringlist.h>
+#include <CppAddons/Simd.h>
+#include <Music/SampleFormat.h>
 	
 class CaptureThread;
 
@@ -69,8 +76,11 @@ class CaptureThreadImplALSA : public CaptureThreadImpl
 {
 	snd_pcm_t* m_alsa_capture_handle;
 	snd_pcm_hw_params_t* m_alsa_hw_params;
-	signed short* m_alsa_buffer;
+	unsigned char* m_alsa_buffer;
 	snd_pcm_format_t m_format;
+	unsigned int m_channel_count;
+	Music::SampleConverter m_converter;	// selected in capture_init
+	Simd::vector_f m_converted;
 
 	void set_params();
 
@@ -138,6 +148,125 @@ class CaptureThreadImplSoundFile : public CaptureThreadImpl
 };
 #endif
 
+// ---------------------- the raw PCM transports ---------------------
+
+#if defined(CAPTURE_PIPE) || defined(CAPTURE_RTP)
+//! the common part of the transports receiving raw interleaved PCM
+/*!
+ * The stream is described by "<format>:<rate>:<channels>" fields in the
+ * source, the rate is the one of the stream and can only be declared.
+ */
+class CaptureThreadImplRawPCM : public CaptureThreadImpl
+{
+  protected:
+	Music::SampleFormat m_format;
+	int m_channel_count;
+
+	//! parse the format, rate and channels fields from fields[first], the empty or missing ones take their default
+	/*!
+	 * the format defaults to default_format, the rate to the last one given, the channels to 1
+	 */
+	void parse_format(const QStringList& fields, int first, Music::SampleFormat default_format);
+
+  public:
+	CaptureThreadImplRawPCM(CaptureThread* capture_thread, const QString& name, const QString& descr, Music::SampleFormat format);
+
+	virtual void setSamplingRate(int rate);
+};
+#endif
+
+// ---------------------- the raw PCM pipe implementation ---------------------
+
+#ifdef CAPTURE_PIPE
+//! raw interleaved PCM from stdin, a named pipe or a file
+/*!
+ * The source is "<path>[:<format>[:<rate>[:<channels>[:offline]]]]", where
+ * the path "-" is stdin, the format one of \ref Music::FindSampleFormat
+ * (s16le by default), the rate the last one given (44100 at first) and the
+ * channels 1 by default, e.g.
+ * "arecord -f S16_LE -c 2 -r 48000 -t raw | coucher" with "-:s16le:48000:2".
+ * The input paces the capture: the thread only waits for the input data.
+ * Offline (a regular file, or the offline flag), the samples are never
+ * dropped and the capture goes as fast as the analysis.
+ */
+class CaptureThreadImplPipe : public CaptureThreadImplRawPCM
+{
+	QString m_path;
+	bool m_offline;
+
+	int m_fd;
+	bool m_fifo;
+	Music::SampleConverter m_converter;
+	vector<unsigned char> m_buffer;
+	size_t m_buffer_size;			// bytes in m_buffer
+	Simd::vector_f m_converted;
+
+	void parse_source();
+	void open_input();
+	void close_input();
+
+  public:
+	CaptureThreadImplPipe(CaptureThread* capture_thread);
+
+	virtual void capture_init();
+	virtual void capture_loop();
+	virtual void capture_finished();
+
+	virtual bool is_available();
+};
+#endif
+
+// ---------------------- the RTP implementation ---------------------
+
+#ifdef CAPTURE_RTP
+#include <stdint.h>
+#include <Music/JitterBuffer.h>
+//! uncompressed PCM RTP packets received on a local UDP port
+/*!
+ * The source is "[<address>:]<port>[:<format>[:<rate>[:<channels>]]]", by
+ * default "127.0.0.1:5004:s16be:44100:1"; "0.0.0.0:5004" receives from the
+ * other hosts. The static payload types 10 and 11 (L16 stereo and mono at
+ * 44100Hz) set the format, the dynamic ones (96-127) use the configured one,
+ * s16be (L16) or f32be.
+ * The packets go through a \ref Music::JitterBuffer which reorders them and
+ * conceals the lost ones. The first SSRC heard is followed, another one is
+ * taken after 2 seconds of silence.
+ * One transport receives one stream, several inputs need several ports.
+ */
+class CaptureThreadImplRTP : public CaptureThreadImplRawPCM
+{
+	QString m_address;
+	int m_port;
+
+	int m_socket;
+	bool m_has_ssrc;
+	uint32_t m_ssrc;
+	double m_last_packet_time;
+	int m_payload_type;
+	Music::SampleConverter m_converter;
+
+	vector<unsigned char> m_packet;
+	Simd::vector_f m_converted;
+	vector<float> m_pulled;
+	Music::JitterBuffer m_jitter_buffer;
+	long m_nb_invalid;
+	long m_nb_foreign;
+
+	void parse_source();
+	void set_payload(int payload_type);
+	void receive_packet(size_t size, double now);
+
+  public:
+	CaptureThreadImplRTP(CaptureThread* capture_thread);
+
+	virtual void capture_init();
+	virtual void capture_loop();
+	virtual void capture_finished();
+
+	virtual bool is_available();
+};
+#endif
+
 // --------------------- the real accessible thread -------------------------
 
 class CaptureThread : public QThread
@@ -153,6 +282,15 @@ class CaptureThread : public QThread
 #ifdef CAPTURE_SOUNDFILE
 	friend class CaptureThreadImplSoundFile;
 #endif
+#if defined(CAPTURE_PIPE) || defined(CAPTURE_RTP)
+	friend class CaptureThreadImplRawPCM;
+#endif
+#ifdef CAPTURE_PIPE
+	friend class CaptureThreadImplPipe;
+#endif
+#ifdef CAPTURE_RTP
+	friend class CaptureThreadImplRTP;
+#endif
 
 	list<CaptureThreadImpl*> m_impls;
 	CaptureThreadImpl* m_current_impl;
@@ -160,28 +298,75 @@ class CaptureThread : public QThread
 	void emitError(const QString& error);
 	void emitSamplingRateChanged();
 
-	bool m_capturing;
+	atomic<bool> m_capturing;
 
-	int m_packet_size;
+	atomic<int> m_packet_size;
 	QString m_name;
 
 	virtual void run();
 
 	// control
-	volatile bool m_loop;
-	volatile bool m_pause;
+	atomic<bool> m_loop;
+	atomic<bool> m_pause;
 
 	// view
-	volatile bool m_alive;
-	volatile bool m_in_run;
+	atomic<bool> m_alive;
+	atomic<bool> m_in_run;
+
+	// the changes of the flags above are signaled on m_state_changed
+	QMutex m_state_lock;
+	QWaitCondition m_state_changed;
+	//! set m_loop and wake the threads waiting for it
+	void setLoop(bool loop);
+	//! wait until the capture has to stop or the timeout elapses {millis}
+	/*!
+	 * \return true if the capture goes on
+	 */
+	bool waitWhileLooping(unsigned long timeout=ULONG_MAX);
 
 	QMutex m_lock;
+	// the consumers waiting for m_nb_wanted samples, see \ref waitForData
+	QWaitCondition m_data_added;
+	int m_nb_wanted;
+	//! to call after adding samples, m_lock locked
+	void notifyData()								{if(int(m_values.size())>=m_nb_wanted) m_data_added.wakeAll();}
+
+	// bounded m_values, see \ref setOverrunPolicy
+	int m_capacity;
+	atomic<int> m_overrun_policy;
+	QWaitCondition m_space_freed;
+	bool m_overrun;					// dropping since the last push
+	bool m_overrun_started;			// to signal after the push
+	int m_nb_pushed;				// by the current push
+	atomic<bool> m_offline;			// the last push could wait for the analysis
+	// stats, protected by m_lock
+	long m_nb_dropped_data;
+	int m_high_water_mark;
+	double m_time_behind;
+	long m_nb_underruns;
+
+	//! lock m_values and make room for n new samples according to the overrun policy
+	/*!
+	 * \param can_block the producer can wait (offline), otherwise BLOCK drops the oldest samples
+	 * \return the number of the n samples to push, the following ones are dropped
+	 */
+	int beginPush(int n, bool can_block=false);
+	//! to call after pushing the samples of \ref beginPush, unlock m_values
+	void endPush();
+
+	// real-time
+	int m_rt_priority;
+	int m_rt_cpu;
+	QString m_rt_status;			// protected by m_lock
+	atomic<int> m_nb_scheduling_misses;
 
   public:
 
 	deque<double> m_values;
 
 	enum {SAMPLING_RATE_UNKNOWN=-1, SAMPLING_RATE_MAX=0};
+	//! what to do with the new samples when the buffer is full
+	enum OverrunPolicy{DROP_OLDEST, DROP_NEWEST, BLOCK};
 
 	CaptureThread(const QString& name="bastard_thread");
 
@@ -192,12 +377,60 @@ class CaptureThread : public QThread
 	int getSamplingRate() const;
 	int getPacketSize() const						{return m_packet_size;}
 	int getNbPendingData() const					{return m_values.size();}
+	//! maximal number of pending samples {samples}
+	void setBufferCapacity(int capacity);
+	int getBufferCapacity() const					{return m_capacity;}
+	//! the policy when the pending samples reach the capacity
+	/*!
+	 * - DROP_OLDEST: the oldest pending samples are dropped (default)
+	 * - DROP_NEWEST: the new samples are dropped
+	 * - BLOCK: the capture waits for the analysis, for the offline transports
+	 *   only (sound file), the real-time ones drop the oldest samples
+	 */
+	void setOverrunPolicy(OverrunPolicy policy)		{m_overrun_policy=policy;}
+	OverrunPolicy getOverrunPolicy() const			{return OverrunPolicy(int(m_overrun_policy));}
+	//! the producer waits for the analysis (BLOCK policy and offline transport)
+	bool isOffline() const							{return m_offline;}
+	//! number of samples lost by overrun since the last \ref resetBufferStats
+	long getNbDroppedData();
+	//! maximal number of pending samples since the last \ref resetBufferStats
+	int getHighWaterMark();
+	//! captured audio while the buffer was more than half full {seconds}
+	double getTimeBehind();
+	//! number of \ref waitForData timeouts during the capture
+	long getNbUnderruns();
+	void resetBufferStats();
+	//! drop the pending samples (not counted as overrun)
+	void clearPendingData();
+	//! to call by the consumer after taking samples, m_lock locked
+	void notifyConsumed()							{m_space_freed.wakeAll();}
+
+	//! block until n samples are pending or the timeout elapses {millis}
+	/*!
+	 * \return true if n samples are pending
+	 */
+	bool waitForData(int n, unsigned long timeout);
+	//! wake up the threads blocked in \ref waitForData
+	void wakeDataWaiters();
 	QString getCurrentTransport() const;
 	QString getCurrentTransportDescr() const;
 	QString getFormatDescr() const;
 	list<QString> getTransports() const;
 	void listTransports();
 
+	//! real-time scheduling of the capture thread, from its next start
+	/*!
+	 * \param priority SCHED_FIFO priority [1;99], 0 for the default scheduling
+	 * \param cpu the cpu the thread is pinned on, -1 for any
+	 */
+	void setRealTime(int priority, int cpu=-1)		{m_rt_priority=priority; m_rt_cpu=cpu;}
+	int getRealTimePriority() const					{return m_rt_priority;}
+	//! the scheduling actually obtained and the number of scheduling misses
+	QString getRealTimeStatus();
+	//! a deadline was missed (a capture overrun, a late analysis, ...)
+	void reportSchedulingMiss();
+	int getNbSchedulingMisses() const				{return m_nb_scheduling_misses;}
+
 	virtual ~CaptureThread();
 
   signals:
@@ -209,6 +442,10 @@ class CaptureThread : public QThread
 	void captureStoped();
 	void captureToggled(bool run);
 	void errorRaised(const QString& error);
+	void schedulingMissed(int nb_misses);
+	//! samples start being dropped, with the total number of dropped samples
+	void overrun(long nb_dropped_data);
+	void underrun(long nb_underruns);
 
   public slots:
 	//! auto detect a working transport
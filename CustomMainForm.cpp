@@ -10,32 +10,19 @@ CustomMainForm::CustomMainForm (QWidget *parent) : QMainWindow (parent)
 	m_timer_refresh = new QTimer(this);
 	connect((QObject*) m_timer_refresh, SIGNAL(timeout()),
 			(QObject*) this, SLOT(refresh()));
-	m_timer_refresh->start(1000);
-}
-
-void CustomMainForm::fill_buffer (void)
-{
-	m_incoming_data = false;
-
-	anr().m_capture_thread.lock();
-
-	while(!anr().m_capture_thread.m_values.empty())
-	{
-		m_incoming_data = true;
-		anr().m_queue.push_front(anr().m_capture_thread.m_values.back());
-		anr().m_capture_thread.m_values.pop_back();
-	}
-
-	anr().m_capture_thread.unlock();
+	m_timer_refresh->start(100);
 }
 
 void CustomMainForm::refresh()
 {
-	if (anr().m_capture_thread.isCapturing())
-		fill_buffer();
-
-	if (m_incoming_data)
-		anr().recognize();
+	// the recognition runs in the analysis thread, only read its last results
+	const AnalysisSnapshot& snapshot = anr().m_analysis_thread.getSnapshot();
+
+	QString title = "coucher";
+	if (snapshot.note!=UNDEFINED_SEMITONE)
+		title += QString(" - ") + QString(h2n(snapshot.note).c_str());
+	title += QString(" (load %1%)").arg(int(100*snapshot.load));
+	setWindowTitle(title);
 
 	//cerr << "CustomMainForm::refresh()" << endl;
 }
@@ -15,8 +15,6 @@ public:
 
 private:
 	QTimer* m_timer_refresh;
-	bool m_incoming_data;
-	void fill_buffer (void);
 
 private slots:
 	void refresh();
@@ -0,0 +1,299 @@
+// Copyright 2005 "Gilles Degottex"
+
+// This file is part of "midingsolo"
+
+// "midingsolo" is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// "midingsolo" is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+/*
+ * Micro benchmarks of the Music library kernels.
+ *
+ * usage: bench [-t min_seconds_per_kernel] [kernel_filter]
+ *
+ * Output one CSV line by kernel, sampling rate and semitone range:
+ *  kernel,sampling_rate,semitone_min,semitone_max,param,calls,samples,mean_ns,p50_ns,p99_ns,samples_per_sec
+ * - samples: number of audio samples read by one call
+ * - samples_per_sec: samples/mean call duration
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <iostream>
+#include <streambuf>
+#include <vector>
+#include <deque>
+using namespace std;
+#include <CppAddons/Histogram.h>
+#include <Music/Music.h>
+#include <Music/ScoreGenerator.h>
+#include <Music/Correlation.h>
+#include <Music/Convolution.h>
+#include <Music/MultiCorrelationAlgo.h>
+#include <Music/AutocorrelationAlgo.h>
+#include <Music/BubbleAlgo.h>
+#include <Music/FreqAnalysis.h>
+#include <Music/TimeAnalysis.h>
+#include <Music/Quantizer.h>
+#include <Music/Resampler.h>
+#include <Music/SampleFormat.h>
+using namespace Music;
+
+//! swallow the debug outputs of the algorithms while measuring
+struct NullBuffer : streambuf
+{
+	virtual int overflow(int c)		{return c;}
+};
+
+struct Config
+{
+	int sampling_rate;
+	int semitone_min;
+	int semitone_max;
+};
+
+static const Config s_configs[] = {
+	{22050, -48, 48},
+	{44100, -48, 48},
+	{48000, -48, 48},
+	{22050, -29, 19},	// guitar in standard tuning
+	{44100, -29, 19},
+	{48000, -29, 19},
+};
+
+static double s_min_time = 0.2;		// seconds
+static const char* s_filter = NULL;
+static NullBuffer s_null;
+
+//! a few frames of one note each, generated with \ref GenerateScore
+struct Frames
+{
+	vector< deque<double> > buffs;
+	vector<int> hts;
+
+	Frames(size_t nb, size_t length)
+	: buffs(nb)
+	, hts(nb)
+	{
+		for(size_t f=0; f<nb; f++)
+		{
+			vector<double> buffer;
+			vector<ScoreEvent> score;
+			GenerateScore(buffer, score, double(length)/GetSamplingRate(), GetSamplingRate(), GetAFreq(), GetSemitoneMin(), GetSemitoneMax(), 1, 1);
+
+			buffs[f].assign(buffer.begin(), buffer.end());
+			hts[f] = score[0].ht;
+		}
+	}
+
+	const deque<double>& operator[](size_t call) const	{return buffs[call%buffs.size()];}
+	int ht(size_t call) const							{return hts[call%hts.size()];}
+};
+
+//! call fn until s_min_time is elapsed and print the resulting CSV line
+template<typename Fn>
+void measure(const char* kernel, const string& param, size_t samples, Fn fn)
+{
+	if(s_filter!=NULL && strstr(kernel, s_filter)==NULL)	return;
+
+	Histogram hist(kernel);
+
+	streambuf* old_cerr = cerr.rdbuf(&s_null);
+	streambuf* old_cout = cout.rdbuf(&s_null);
+
+	uint64_t min_time = uint64_t(s_min_time*1e9);
+	uint64_t start = Histogram::now();
+	uint64_t end = start;
+	size_t calls = 0;
+	while(end-start<min_time || calls<3)
+	{
+		uint64_t t = Histogram::now();
+		fn(calls);
+		end = Histogram::now();
+		hist.record(end-t);
+		calls++;
+	}
+
+	cerr.rdbuf(old_cerr);
+	cout.rdbuf(old_cout);
+
+	double mean = hist.getMean();
+	cout << kernel << "," << GetSamplingRate() << "," << GetSemitoneMin() << "," << GetSemitoneMax()
+		<< "," << param << "," << calls << "," << samples
+		<< "," << uint64_t(mean) << "," << hist.getValueAtPercentile(50) << "," << hist.getValueAtPercentile(99)
+		<< "," << uint64_t((mean>0.0)?samples*1e9/mean:0.0) << endl;
+}
+
+//! an Algorithm::apply on the frames
+void measure_algorithm(const char* kernel, Algorithm* algo, const Frames& frames)
+{
+	measure(kernel, "", algo->getSampleAlgoLatency(), [&](size_t call){Frame frame(frames[call]); algo->apply(frame);});
+}
+
+void run(const Config& config)
+{
+	SetSamplingRate(config.sampling_rate);
+	SetSemitoneBounds(config.semitone_min, config.semitone_max);
+
+	size_t max_wave_length = size_t(GetSamplingRate()/h2f(GetSemitoneMin()))+1;
+	double conv_latency_factor = 8.0;
+	Frames frames(4, size_t((conv_latency_factor+2)*max_wave_length));
+
+	// Correlation::receive, once for each semitone
+	{
+		vector<Correlation*> corrs;
+		size_t samples = 0;
+		for(int ht=GetSemitoneMin(); ht<=GetSemitoneMax(); ht++)
+		{
+			corrs.push_back(new Correlation(1.0, ht));
+			samples += 2*corrs.back()->m_s;
+		}
+		measure("Correlation::receive", StringAddons::toString(corrs.size()), samples, [&](size_t call){
+			for(size_t i=0; i<corrs.size(); i++)
+				corrs[i]->receive(frames[call]);
+		});
+		for(size_t i=0; i<corrs.size(); i++)
+			delete corrs[i];
+	}
+
+	// RangedCorrelation::receive, once for each semitone
+	{
+		vector<RangedCorrelation*> corrs;
+		size_t samples = 0;
+		for(int ht=GetSemitoneMin(); ht<=GetSemitoneMax(); ht++)
+		{
+			corrs.push_back(new RangedCorrelation(0.5, 1.0, ht));
+			samples += 2*corrs.back()->m_smax;
+		}
+		measure("RangedCorrelation::receive", StringAddons::toString(corrs.size()), samples, [&](size_t call){
+			for(size_t i=0; i<corrs.size(); i++)
+				corrs[i]->receive(frames[call]);
+		});
+		for(size_t i=0; i<corrs.size(); i++)
+			delete corrs[i];
+	}
+
+	// Convolution::apply, once for each semitone
+	{
+		vector<Convolution*> convs;
+		size_t samples = 0;
+		for(int ht=GetSemitoneMin(); ht<=GetSemitoneMax(); ht++)
+		{
+			convs.push_back(new Convolution(conv_latency_factor, 2.0, ht));
+			samples += convs.back()->size();
+		}
+		// the samples are converted once for all the convolutions, as the transforms do
+		Simd::vector_f fbuff;
+		measure("Convolution::apply", StringAddons::toString(convs.size()), samples, [&](size_t call){
+			Convolution::ToFloats(frames[call], convs[0]->size(), fbuff);
+			for(size_t i=0; i<convs.size(); i++)
+				convs[i]->apply(fbuff.data(), fbuff.size());
+		});
+		for(size_t i=0; i<convs.size(); i++)
+			delete convs[i];
+	}
+
+	// Resampler::process of a hop from the usual device rates to the analysis rate
+	{
+		int rates[] = {44100, 48000, 96000};
+		for(size_t r=0; r<sizeof(rates)/sizeof(rates[0]); r++)
+		{
+			Resampler resampler(rates[r], GetSamplingRate());
+			vector<double> in(frames[0].begin(), frames[0].end());
+			vector<double> out;
+			measure("Resampler::process", StringAddons::toString(rates[r]), in.size(), [&](size_t call){
+				out.clear();
+				resampler.process(&in[0], in.size(), out);
+			});
+		}
+	}
+
+	// SampleConverter of a capture packet, mono and stereo
+	{
+		size_t frames_nb = 1024;
+		vector<unsigned char> packet(frames_nb*2*4, 0x55);
+		Simd::vector_f out(frames_nb);
+		for(int format=0; format<SAMPLE_UNKNOWN; format++)
+			for(int channels=1; channels<=2; channels++)
+			{
+				SampleConverter converter = GetSampleConverter(SampleFormat(format), channels);
+				measure("SampleConverter", string(GetSampleFormatName(SampleFormat(format)))+"x"+StringAddons::toString(channels), frames_nb, [&](size_t){
+					converter(&packet[0], frames_nb, channels, &out[0]);
+				});
+			}
+	}
+
+	// Algorithm::apply of all the algorithms
+	// (construction is silenced, some of them are verbose)
+	streambuf* old_cerr = cerr.rdbuf(&s_null);
+	MultiCorrelationAlgo* multicorr = new MultiCorrelationAlgo(1, 2.0);
+	AutocorrelationAlgo* autocorr = new AutocorrelationAlgo(0.1);
+	BubbleAlgo* bubble = new BubbleAlgo();
+	MonophonicAlgo* monophonic = new MonophonicAlgo(conv_latency_factor, 2.0);
+	NeuralNetGaussAlgo* neuralnet = new NeuralNetGaussAlgo(conv_latency_factor, 2.0);
+	cerr.rdbuf(old_cerr);
+
+	measure_algorithm("MultiCorrelationAlgo::apply", multicorr, frames);
+	measure_algorithm("AutocorrelationAlgo::apply", autocorr, frames);
+	measure_algorithm("BubbleAlgo::apply", bubble, frames);
+	measure_algorithm("MonophonicAlgo::apply", monophonic, frames);
+	measure("NeuralNetGaussAlgo::apply", "", monophonic->getSampleAlgoLatency(), [&](size_t call){Frame frame(frames[call]); neuralnet->apply(frame);});
+
+	delete multicorr;
+	delete autocorr;
+	delete bubble;
+	delete monophonic;
+	delete neuralnet;
+
+	// Quantizer::quantize, with the frame's note playing
+	{
+		Quantizer quantizer;
+		vector<bool> playing(GetNbSemitones());
+		measure("Quantizer::quantize", "", 0, [&](size_t call){
+			for(size_t h=0; h<playing.size(); h++)
+				playing[h] = int(h)+GetSemitoneMin()==frames.ht(call);
+			quantizer.quantize(playing, GetSemitoneMin());
+		});
+	}
+
+	// GetAverageWaveLengthFromApprox on 8 periods of the frame's note
+	{
+		int n = 8;
+		measure("GetAverageWaveLengthFromApprox", StringAddons::toString(n), n*max_wave_length, [&](size_t call){
+			GetAverageWaveLengthFromApprox(frames[call], size_t(GetSamplingRate()/h2f(frames.ht(call))), n);
+		});
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	for(int i=1; i<argc; i++)
+	{
+		if(strcmp(argv[i], "-t")==0 && i+1<argc)
+			s_min_time = atof(argv[++i]);
+		else if(argv[i][0]=='-')
+		{
+			cerr << "usage: " << argv[0] << " [-t min_seconds_per_kernel] [kernel_filter]" << endl;
+			return 1;
+		}
+		else
+			s_filter = argv[i];
+	}
+
+	cout << "kernel,sampling_rate,semitone_min,semitone_max,param,calls,samples,mean_ns,p50_ns,p99_ns,samples_per_sec" << endl;
+
+	for(size_t c=0; c<sizeof(s_configs)/sizeof(s_configs[0]); c++)
+		run(s_configs[c]);
+
+	return 0;
+}
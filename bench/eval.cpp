@@ -0,0 +1,368 @@
+// Copyright 2005 "Gilles Degottex"
+
+// This file is part of "midingsolo"
+
+// "midingsolo" is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// "midingsolo" is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+/*
+ * Accuracy versus cost of the detectors on generated corpora.
+ *
+ * usage: eval [-l seconds] [-r sampling_rate] [-h hop_millis] [-s seed] [-p instrument_profile] [detector_filter]
+ *
+ * Each detector analyses the same frames, spaced by the hop, as ANR does
+ * (most recent sample first). Only the voiced frames whose whole analysis
+ * window covers a single note are scored:
+ * - accuracy: the detected semitone is the right one
+ * - octave: the detected semitone is off by a non null number of octaves
+ * - miss: no note detected
+ * - cpu: process CPU time of Algorithm::apply by second of audio {millis}
+ *   (all the threads of an EnsembleAlgo are counted)
+ *   (the detectors share the Frame of each hop: the first one asking for a
+ *   feature pays for it)
+ * A '*' marks the detectors on the Pareto front of (cpu, accuracy).
+ * The corpora are played in the guitar range, the profile restricts the
+ * analysed range (full by default).
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <iostream>
+#include <iomanip>
+#include <streambuf>
+#include <string>
+#include <vector>
+#include <deque>
+#include <algorithm>
+using namespace std;
+#include <CppAddons/Random.h>
+#include <Music/Music.h>
+#include <Music/ScoreGenerator.h>
+#include <Music/MultiCorrelationAlgo.h>
+#include <Music/AutocorrelationAlgo.h>
+#include <Music/BubbleAlgo.h>
+#include <Music/FreqAnalysis.h>
+#include <Music/EnsembleAlgo.h>
+#include <Music/InstrumentProfile.h>
+using namespace Music;
+
+//! swallow the debug outputs of the algorithms
+struct NullBuffer : streambuf
+{
+	virtual int overflow(int c)		{return c;}
+};
+static NullBuffer s_null;
+
+static double s_length = 8.0;		// seconds by corpus
+static int s_rate = 44100;
+static double s_hop = 10.0;			// millis
+static long s_seed = 1;				// reproducible corpora by default
+static const char* s_filter = NULL;
+static const InstrumentProfile* s_profile = NULL;
+static vector<Algorithm*> s_members;		// of the ensembles
+
+static const int s_lowest_note = -29;	// guitar E
+static const int s_highest_note = 19;
+
+static uint64_t cpu_time()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+	return uint64_t(ts.tv_sec)*1000000000ULL + uint64_t(ts.tv_nsec);
+}
+
+// ----------------------------- the detectors ------------------------------
+
+struct Detector
+{
+	string name;
+	string params;
+	Algorithm* algo;
+
+	// Algorithm::track between the full detections, as ANR does
+	bool tracking;
+	int nb_tracked;
+
+	// results
+	size_t frames, right, octave, miss;
+	uint64_t cpu;
+
+	Detector(const string& n, const string& p, Algorithm* a, bool t=false)
+	: name(n), params(p), algo(a), tracking(t), nb_tracked(0), frames(0), right(0), octave(0), miss(0), cpu(0) {}
+
+	double rate(size_t n) const		{return (frames>0)?100.0*n/frames:0.0;}
+};
+
+//! all the detectors and their parameters to compare
+void build_detectors(vector<Detector>& detectors)
+{
+	streambuf* old_cerr = cerr.rdbuf(&s_null);
+
+	int latencies[] = {1, 2};
+	double complexities[] = {1.0, 4.0};
+	double thresholds[] = {0.2, 0.5};
+	for(size_t l=0; l<sizeof(latencies)/sizeof(latencies[0]); l++)
+		for(size_t c=0; c<sizeof(complexities)/sizeof(complexities[0]); c++)
+			for(size_t t=0; t<sizeof(thresholds)/sizeof(thresholds[0]); t++)
+			{
+				MultiCorrelationAlgo* algo = new MultiCorrelationAlgo(latencies[l], complexities[c]);
+				algo->setComponentsTreshold(thresholds[t]);
+				algo->setHarmonics(s_profile->harmonics);
+				detectors.push_back(Detector("MultiCorrelationAlgo",
+					"latency="+StringAddons::toString(latencies[l])+" complexity="+StringAddons::toString(complexities[c])+" threshold="+StringAddons::toString(thresholds[t]),
+					algo));
+			}
+
+	for(size_t l=0; l<sizeof(latencies)/sizeof(latencies[0]); l++)
+	{
+		MultiCorrelationAlgo* algo = new MultiCorrelationAlgo(latencies[l], 4.0);
+		algo->setComponentsTreshold(0.5);
+		algo->setHarmonics(s_profile->harmonics);
+		algo->setTracking(true);
+		detectors.push_back(Detector("MultiCorrelationAlgo",
+			"latency="+StringAddons::toString(latencies[l])+" complexity=4 tracking",
+			algo, true));
+	}
+
+	double noises[] = {0.05, 0.1, 0.2};
+	for(size_t n=0; n<sizeof(noises)/sizeof(noises[0]); n++)
+		detectors.push_back(Detector("AutocorrelationAlgo", "noise="+StringAddons::toString(noises[n]), new AutocorrelationAlgo(noises[n])));
+
+	detectors.push_back(Detector("BubbleAlgo", "", new BubbleAlgo()));
+
+	for(size_t l=0; l<sizeof(latencies)/sizeof(latencies[0]); l++)
+	{
+		MultiCorrelationAlgo* multicorr = new MultiCorrelationAlgo(latencies[l], 1.0);
+		multicorr->setComponentsTreshold(0.5);
+		multicorr->setHarmonics(s_profile->harmonics);
+		AutocorrelationAlgo* autocorr = new AutocorrelationAlgo(0.1);
+		s_members.push_back(multicorr);
+		s_members.push_back(autocorr);
+
+		EnsembleAlgo* algo = new EnsembleAlgo();
+		algo->add(multicorr);
+		algo->add(autocorr, 0.5);
+		detectors.push_back(Detector("EnsembleAlgo",
+			"latency="+StringAddons::toString(latencies[l])+" complexity=1 +autocorr",
+			algo));
+	}
+
+	double conv_latencies[] = {4.0, 8.0};
+	for(size_t l=0; l<sizeof(conv_latencies)/sizeof(conv_latencies[0]); l++)
+		detectors.push_back(Detector("MonophonicAlgo", "latency="+StringAddons::toString(conv_latencies[l])+" gauss=2", new MonophonicAlgo(conv_latencies[l], 2.0)));
+
+	cerr.rdbuf(old_cerr);
+
+	if(s_filter!=NULL)
+		for(size_t d=0; d<detectors.size(); )
+		{
+			if(detectors[d].name.find(s_filter)==string::npos)
+			{
+				delete detectors[d].algo;
+				detectors.erase(detectors.begin()+d);
+			}
+			else
+				d++;
+		}
+}
+
+// ----------------------------- the corpora ------------------------------
+
+//! pure sinusoids
+void generate_sines(vector<double>& buffer, vector<ScoreEvent>& score)
+{
+	GenerateScore(buffer, score, s_length, GetSamplingRate(), GetAFreq(), s_lowest_note, s_highest_note, int(2*s_length), 1);
+}
+
+//! harmonic instruments with random harmonics amplitudes
+void generate_harmonics(vector<double>& buffer, vector<ScoreEvent>& score)
+{
+	vector<Instrument*> instrs;
+	for(int i=0; i<4; i++)
+	{
+		vector< Math::polar<double> > freqs(1+Random::s_random.nextInt(MAX_NB_HARM));
+		for(size_t h=0; h<freqs.size(); h++)
+			freqs[h] = Math::polar<double>(Random::s_random.nextDouble(), 2*Math::Pi*Random::s_random.nextDouble());
+		freqs[0].mod = freqs[0].mod*0.8 + 0.2;
+		instrs.push_back(new HarmInstrument(GetSamplingRate(), freqs, GetAFreq()));
+	}
+
+	// GenerateScoreFromInstruments keeps 36 semitones above the played ones
+	GenerateScoreFromInstruments(buffer, score, instrs, s_length, GetSamplingRate(), GetAFreq(), s_lowest_note, s_highest_note+36, int(2*s_length), 1);
+
+	for(size_t i=0; i<instrs.size(); i++)
+		delete instrs[i];
+}
+
+// ----------------------------- the evaluation ------------------------------
+
+void evaluate(const string& corpus, const vector<double>& buffer, const vector<ScoreEvent>& score, vector<Detector>& detectors)
+{
+	size_t window = 0;
+	for(size_t d=0; d<detectors.size(); d++)
+	{
+		window = max(window, size_t(detectors[d].algo->getSampleAlgoLatency()));
+		detectors[d].frames = detectors[d].right = detectors[d].octave = detectors[d].miss = 0;
+		detectors[d].cpu = 0;
+	}
+	size_t hop = max(size_t(1), size_t(s_hop*GetSamplingRate()/1000.0));
+
+	streambuf* old_cerr = cerr.rdbuf(&s_null);
+
+	deque<double> queue;
+	for(size_t t=0; t<buffer.size(); t++)
+	{
+		queue.push_front(buffer[t]);
+		if(queue.size()>2*window)
+			queue.pop_back();
+
+		if(t<2*window || t%hop!=0)	continue;
+
+		Frame frame(queue);
+
+		for(size_t d=0; d<detectors.size(); d++)
+		{
+			Detector& det = detectors[d];
+
+			uint64_t start = cpu_time();
+			if(det.tracking && det.algo->hasNoteRecognized() && det.nb_tracked<8 && det.algo->track(frame))
+				det.nb_tracked++;
+			else
+			{
+				det.algo->apply(frame);
+				det.nb_tracked = 0;
+			}
+			det.cpu += cpu_time()-start;
+
+			// score only the frames fully covered by one note
+			size_t latency = det.algo->getSampleAlgoLatency();
+			if(latency>t)	continue;
+			int truth = GetSingleNote(score, t-latency, t+1);
+			if(truth==UNDEFINED_SEMITONE)
+				continue;
+
+			det.frames++;
+			if(!det.algo->hasNoteRecognized())
+				det.miss++;
+			else
+			{
+				int ht = int(floor(det.algo->getFondamentalNote()+0.5));
+				if(ht==truth)
+					det.right++;
+				else if((ht-truth)%12==0)
+					det.octave++;
+			}
+		}
+	}
+
+	cerr.rdbuf(old_cerr);
+
+	// sort by cost and mark the Pareto front
+	vector<size_t> order(detectors.size());
+	for(size_t d=0; d<order.size(); d++)
+		order[d] = d;
+	for(size_t i=0; i<order.size(); i++)
+		for(size_t j=i+1; j<order.size(); j++)
+			if(detectors[order[j]].cpu<detectors[order[i]].cpu)
+				swap(order[i], order[j]);
+
+	double audio_length = double(buffer.size())/GetSamplingRate();
+
+	cout << endl << "corpus " << corpus << " (" << audio_length << "s at " << GetSamplingRate() << "Hz, notes in [" << s_lowest_note << ";" << s_highest_note << "], " << s_profile->name << " profile)" << endl;
+	cout << setw(22) << left << "detector" << setw(40) << "params" << right
+		<< setw(8) << "frames" << setw(10) << "accuracy" << setw(8) << "octave" << setw(8) << "other" << setw(8) << "miss"
+		<< setw(12) << "cpu(ms/s)" << "  pareto" << endl;
+
+	double best_accuracy = -1.0;
+	for(size_t i=0; i<order.size(); i++)
+	{
+		const Detector& det = detectors[order[i]];
+		double accuracy = det.rate(det.right);
+
+		// sorted by cost: on the front if more accurate than all the cheaper ones
+		bool pareto = accuracy>best_accuracy;
+		best_accuracy = max(best_accuracy, accuracy);
+
+		cout << setw(22) << left << det.name << setw(40) << det.params << right << fixed << setprecision(1)
+			<< setw(8) << det.frames
+			<< setw(9) << accuracy << "%"
+			<< setw(7) << det.rate(det.octave) << "%"
+			<< setw(7) << det.rate(det.frames-det.right-det.octave-det.miss) << "%"
+			<< setw(7) << det.rate(det.miss) << "%"
+			<< setw(12) << det.cpu/1e6/audio_length
+			<< "  " << (pareto?"*":"") << endl;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	for(int i=1; i<argc; i++)
+	{
+		if(strcmp(argv[i], "-l")==0 && i+1<argc)
+			s_length = atof(argv[++i]);
+		else if(strcmp(argv[i], "-r")==0 && i+1<argc)
+			s_rate = atoi(argv[++i]);
+		else if(strcmp(argv[i], "-h")==0 && i+1<argc)
+			s_hop = atof(argv[++i]);
+		else if(strcmp(argv[i], "-s")==0 && i+1<argc)
+			s_seed = atol(argv[++i]);
+		else if(strcmp(argv[i], "-p")==0 && i+1<argc)
+		{
+			s_profile = FindInstrumentProfile(argv[++i]);
+			if(s_profile==NULL)
+			{
+				cerr << "unknown instrument profile " << argv[i] << endl;
+				return 1;
+			}
+		}
+		else if(argv[i][0]=='-')
+		{
+			cerr << "usage: " << argv[0] << " [-l seconds] [-r sampling_rate] [-h hop_millis] [-s seed] [-p instrument_profile] [detector_filter]" << endl;
+			return 1;
+		}
+		else
+			s_filter = argv[i];
+	}
+
+	if(s_profile==NULL)
+		s_profile = &GetInstrumentProfiles()[0];
+
+	SetSamplingRate(s_rate);
+	SetSemitoneBounds(s_profile->semitone_min, s_profile->semitone_max);
+	Random::s_random.setSeed(s_seed);
+
+	vector<Detector> detectors;
+	build_detectors(detectors);
+
+	{
+		vector<double> buffer;
+		vector<ScoreEvent> score;
+		generate_sines(buffer, score);
+		evaluate("sines", buffer, score, detectors);
+	}
+	{
+		vector<double> buffer;
+		vector<ScoreEvent> score;
+		generate_harmonics(buffer, score);
+		evaluate("harmonics", buffer, score, detectors);
+	}
+
+	for(size_t d=0; d<detectors.size(); d++)
+		delete detectors[d].algo;
+	for(size_t m=0; m<s_members.size(); m++)
+		delete s_members[m];
+
+	return 0;
+}
@@ -0,0 +1,183 @@
+// Copyright 2005 "Gilles Degottex"
+
+// This file is part of "midingsolo"
+
+// "midingsolo" is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// "midingsolo" is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+/*
+ * Send a tone as uncompressed PCM RTP packets, to test the RTP transport.
+ *
+ * usage: rtpsend [-a address] [-p port] [-r sampling_rate] [-c channels] [-n frames_by_packet]
+ *                [-f s16be|f32be] [-t tone_hz] [-d seconds] [-l loss_percent] [-o reorder_percent] [-s seed]
+ *
+ * The packets are sent in real time. The losses are simulated by skipping
+ * packets, the reordering by swapping a packet with the next one.
+ * L16 at 44100Hz is sent with the static payload types (10 stereo, 11 mono),
+ * the other formats with the dynamic payload type 96.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <iostream>
+#include <vector>
+using namespace std;
+#include <CppAddons/Random.h>
+
+static string s_address = "127.0.0.1";
+static int s_port = 5004;
+static int s_rate = 44100;
+static int s_channels = 1;
+static int s_frames = 256;
+static bool s_float = false;
+static double s_tone = 440.0;
+static double s_length = 10.0;		// seconds
+static int s_loss = 0;				// percents
+static int s_reorder = 0;			// percents
+static long s_seed = 0;
+
+static void put16(unsigned char* p, uint16_t v)	{p[0]=v>>8; p[1]=v;}
+static void put32(unsigned char* p, uint32_t v)	{p[0]=v>>24; p[1]=v>>16; p[2]=v>>8; p[3]=v;}
+
+//! the RTP packet of the frames [frame;frame+s_frames[
+static void make_packet(vector<unsigned char>& packet, uint16_t seq, uint32_t frame)
+{
+	int sample_size = s_float?4:2;
+	packet.resize(12+s_frames*s_channels*sample_size);
+
+	int payload_type = 96;
+	if(!s_float && s_rate==44100 && s_channels<=2)
+		payload_type = (s_channels==2)?10:11;
+
+	packet[0] = 0x80;		// version 2
+	packet[1] = payload_type;
+	put16(&packet[2], seq);
+	put32(&packet[4], frame);
+	put32(&packet[8], 0x636f7563);
+
+	unsigned char* p = &packet[12];
+	for(int i=0; i<s_frames; i++)
+	{
+		double value = 0.5*sin(2*M_PI*s_tone*double(frame+i)/s_rate);
+		for(int c=0; c<s_channels; c++, p+=sample_size)
+		{
+			if(s_float)
+			{
+				float f = value;
+				uint32_t u;
+				memcpy(&u, &f, sizeof(u));
+				put32(p, u);
+			}
+			else
+				put16(p, uint16_t(int16_t(lrint(32767*value))));
+		}
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	for(int i=1; i<argc; i++)
+	{
+		if(strcmp(argv[i], "-a")==0 && i+1<argc)
+			s_address = argv[++i];
+		else if(strcmp(argv[i], "-p")==0 && i+1<argc)
+			s_port = atoi(argv[++i]);
+		else if(strcmp(argv[i], "-r")==0 && i+1<argc)
+			s_rate = atoi(argv[++i]);
+		else if(strcmp(argv[i], "-c")==0 && i+1<argc)
+			s_channels = atoi(argv[++i]);
+		else if(strcmp(argv[i], "-n")==0 && i+1<argc)
+			s_frames = atoi(argv[++i]);
+		else if(strcmp(argv[i], "-f")==0 && i+1<argc)
+			s_float = strcmp(argv[++i], "f32be")==0;
+		else if(strcmp(argv[i], "-t")==0 && i+1<argc)
+			s_tone = atof(argv[++i]);
+		else if(strcmp(argv[i], "-d")==0 && i+1<argc)
+			s_length = atof(argv[++i]);
+		else if(strcmp(argv[i], "-l")==0 && i+1<argc)
+			s_loss = atoi(argv[++i]);
+		else if(strcmp(argv[i], "-o")==0 && i+1<argc)
+			s_reorder = atoi(argv[++i]);
+		else if(strcmp(argv[i], "-s")==0 && i+1<argc)
+			s_seed = atol(argv[++i]);
+		else
+		{
+			cerr << "usage: " << argv[0] << " [-a address] [-p port] [-r sampling_rate] [-c channels] [-n frames_by_packet]" << endl
+				<< "       [-f s16be|f32be] [-t tone_hz] [-d seconds] [-l loss_percent] [-o reorder_percent] [-s seed]" << endl;
+			return 1;
+		}
+	}
+
+	Random::s_random.setSeed(s_seed);
+
+	int s = socket(AF_INET, SOCK_DGRAM, 0);
+	struct sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(s_port);
+	if(s<0 || inet_aton(s_address.c_str(), &addr.sin_addr)==0)
+	{
+		cerr << "cannot send to " << s_address << ":" << s_port << endl;
+		return 1;
+	}
+
+	int nb_packets = int(s_length*s_rate/s_frames);
+	int nb_sent = 0;
+	vector<unsigned char> packet;
+	vector<unsigned char> held;
+
+	struct timespec next;
+	clock_gettime(CLOCK_MONOTONIC, &next);
+	for(int k=0; k<nb_packets; k++)
+	{
+		make_packet(packet, uint16_t(k), uint32_t(k*s_frames));
+
+		if(Random::s_random.nextInt(100)<s_loss)
+			continue;
+
+		if(held.empty() && Random::s_random.nextInt(100)<s_reorder)
+			held.swap(packet);
+		else
+		{
+			sendto(s, &packet[0], packet.size(), 0, (struct sockaddr*)&addr, sizeof(addr));
+			nb_sent++;
+			if(!held.empty())
+			{
+				sendto(s, &held[0], held.size(), 0, (struct sockaddr*)&addr, sizeof(addr));
+				held.clear();
+				nb_sent++;
+			}
+		}
+
+		// real-time pacing
+		next.tv_nsec += long(1e9*s_frames/s_rate);
+		next.tv_sec += next.tv_nsec/1000000000;
+		next.tv_nsec %= 1000000000;
+		while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL)==EINTR);
+	}
+
+	cerr << nb_sent << "/" << nb_packets << " packets sent" << endl;
+
+	close(s);
+
+	return 0;
+}
@@ -0,0 +1,151 @@
+// Copyright 2003 "Gilles Degottex"
+
+// This file is part of "CppAddons"
+
+// "CppAddons" is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 2.1 of the License, or
+// (at your option) any later version.
+//
+// "CppAddons" is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+#include "Histogram.h"
+
+#include <signal.h>
+#include <stdlib.h>
+#include <iomanip>
+using namespace std;
+
+list<Histogram*> Histogram::s_histograms;
+bool Histogram::s_enabled = false;
+volatile sig_atomic_t Histogram::s_dump_requested = 0;
+
+Histogram::Histogram(const string& name)
+: m_name(name)
+{
+	reset();
+
+	s_histograms.push_back(this);
+}
+
+int Histogram::index(uint64_t value)
+{
+	if(value<2*SUB_BUCKETS)	return int(value);
+
+	int msb = 63 - __builtin_clzll(value);
+	int shift = msb - SUB_BUCKETS_BITS;
+
+	return shift*SUB_BUCKETS + int(value>>shift);
+}
+uint64_t Histogram::lowest(int i)
+{
+	if(i<2*SUB_BUCKETS)	return uint64_t(i);
+
+	int shift = i/SUB_BUCKETS - 1;
+
+	return uint64_t(i%SUB_BUCKETS + SUB_BUCKETS) << shift;
+}
+uint64_t Histogram::highest(int i)
+{
+	if(i<2*SUB_BUCKETS)	return uint64_t(i);
+
+	int shift = i/SUB_BUCKETS - 1;
+
+	return lowest(i) + (uint64_t(1)<<shift) - 1;
+}
+
+uint64_t Histogram::getMin() const
+{
+	if(getCount()==0)	return 0;
+
+	return m_min.load(memory_order_relaxed);
+}
+double Histogram::getMean() const
+{
+	uint64_t n = getCount();
+	if(n==0)	return 0.0;
+
+	return double(m_sum.load(memory_order_relaxed))/n;
+}
+uint64_t Histogram::getValueAtPercentile(double p) const
+{
+	uint64_t n = getCount();
+	if(n==0)	return 0;
+
+	uint64_t rank = uint64_t(p/100.0*n + 0.5);
+	if(rank<1)	rank = 1;
+	if(rank>n)	rank = n;
+
+	uint64_t count = 0;
+	for(int i=0; i<NB_BUCKETS; i++)
+	{
+		count += m_counts[i].load(memory_order_relaxed);
+		if(count>=rank)
+			return min(highest(i), getMax());
+	}
+
+	return getMax();
+}
+
+void Histogram::reset()
+{
+	for(int i=0; i<NB_BUCKETS; i++)
+		m_counts[i].store(0, memory_order_relaxed);
+	m_total.store(0, memory_order_relaxed);
+	m_sum.store(0, memory_order_relaxed);
+	m_min.store(~uint64_t(0), memory_order_relaxed);
+	m_max.store(0, memory_order_relaxed);
+}
+
+void Histogram::dump(ostream& out) const
+{
+	out << setw(12) << left << m_name << right << fixed << setprecision(1)
+		<< " n=" << getCount()
+		<< " min=" << getMin()/1000.0
+		<< " p50=" << getValueAtPercentile(50)/1000.0
+		<< " p90=" << getValueAtPercentile(90)/1000.0
+		<< " p99=" << getValueAtPercentile(99)/1000.0
+		<< " p99.9=" << getValueAtPercentile(99.9)/1000.0
+		<< " max=" << getMax()/1000.0
+		<< " mean=" << getMean()/1000.0 << " (us)" << endl;
+}
+
+void Histogram::dumpAll(ostream& out)
+{
+	for(list<Histogram*>::iterator it=s_histograms.begin(); it!=s_histograms.end(); ++it)
+		(*it)->dump(out);
+}
+
+void Histogram::signal_handler(int)
+{
+	s_dump_requested = 1;
+}
+void Histogram::dump_at_exit()
+{
+	if(isEnabled())
+		dumpAll(cerr);
+}
+void Histogram::installDump(int sig)
+{
+	static bool s_at_exit_installed = false;
+	if(!s_at_exit_installed)
+	{
+		atexit(dump_at_exit);
+		s_at_exit_installed = true;
+	}
+
+	signal(sig, signal_handler);
+}
+
+Histogram::~Histogram()
+{
+	s_histograms.remove(this);
+}
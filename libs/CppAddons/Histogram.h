@@ -0,0 +1,136 @@
+// Copyright 2003 "Gilles Degottex"
+
+// This file is part of "CppAddons"
+
+// "CppAddons" is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 2.1 of the License, or
+// (at your option) any later version.
+//
+// "CppAddons" is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+#ifndef _Histogram_h_
+#define _Histogram_h_
+
+#include <time.h>
+#include <signal.h>
+#include <stdint.h>
+#include <string>
+#include <list>
+#include <iostream>
+#include <atomic>
+
+//! fixed memory, log-linear (HDR like) histogram of durations in nanoseconds
+/*!
+ * Values lower than 2*SUB_BUCKETS are stored exactly, above each power of two
+ * is split in SUB_BUCKETS linear buckets (relative precision of ~3%).
+ * There is only one writer (the thread calling \ref record), readers from
+ * other threads get a slightly out of date but consistent enough view.
+ */
+class Histogram
+{
+  public:
+	enum {SUB_BUCKETS_BITS=5, SUB_BUCKETS=1<<SUB_BUCKETS_BITS, NB_BUCKETS=(64-SUB_BUCKETS_BITS)*SUB_BUCKETS+SUB_BUCKETS};
+
+  private:
+	static std::list<Histogram*> s_histograms;
+	static bool s_enabled;
+	static volatile sig_atomic_t s_dump_requested;
+
+	std::string m_name;
+
+	std::atomic<uint64_t> m_counts[NB_BUCKETS];
+	std::atomic<uint64_t> m_total;
+	std::atomic<uint64_t> m_sum;
+	std::atomic<uint64_t> m_min;
+	std::atomic<uint64_t> m_max;
+
+	static int index(uint64_t value);
+	static uint64_t lowest(int i);
+	static uint64_t highest(int i);
+
+	// single writer: avoid the locked instructions of fetch_add
+	static void inc(std::atomic<uint64_t>& c, uint64_t v)	{c.store(c.load(std::memory_order_relaxed)+v, std::memory_order_relaxed);}
+
+	static void signal_handler(int sig);
+	static void dump_at_exit();
+
+  public:
+	Histogram(const std::string& name);
+
+	const std::string& getName() const				{return m_name;}
+
+	//! add a value {nanoseconds}
+	void record(uint64_t value)
+	{
+		inc(m_counts[index(value)], 1);
+		inc(m_total, 1);
+		inc(m_sum, value);
+		if(value<m_min.load(std::memory_order_relaxed))	m_min.store(value, std::memory_order_relaxed);
+		if(value>m_max.load(std::memory_order_relaxed))	m_max.store(value, std::memory_order_relaxed);
+	}
+
+	uint64_t getCount() const						{return m_total.load(std::memory_order_relaxed);}
+	uint64_t getMin() const;
+	uint64_t getMax() const							{return m_max.load(std::memory_order_relaxed);}
+	double getMean() const;
+	//! \param p percentile [0;100]
+	uint64_t getValueAtPercentile(double p) const;
+
+	void reset();
+
+	//! one line summary, values in microseconds
+	void dump(std::ostream& out) const;
+
+	//! enable/disable all the \ref ScopedTimer
+	static void setEnabled(bool enabled)			{s_enabled=enabled;}
+	static bool isEnabled()							{return s_enabled;}
+
+	//! monotonic clock {nanoseconds}
+	static uint64_t now()
+	{
+		struct timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		return uint64_t(ts.tv_sec)*1000000000ULL + uint64_t(ts.tv_nsec);
+	}
+
+	static void dumpAll(std::ostream& out);
+	//! dump all histograms when receiving sig and when the process exits
+	/*! the signal handler only raises a flag, the dump itself is done in \ref dumpIfRequested
+	 */
+	static void installDump(int sig);
+	static void dumpIfRequested(std::ostream& out)	{if(s_dump_requested){s_dump_requested=0; dumpAll(out);}}
+
+	~Histogram();
+};
+
+//! record the life time of the object in a \ref Histogram
+/*! does nothing (not even reading the clock) if the histograms are disabled
+ */
+class ScopedTimer
+{
+	Histogram* m_histogram;
+	uint64_t m_start;
+
+  public:
+	ScopedTimer(Histogram& histogram)
+	: m_histogram(Histogram::isEnabled()?&histogram:NULL)
+	, m_start(m_histogram?Histogram::now():0)
+	{}
+
+	~ScopedTimer()
+	{
+		if(m_histogram)
+			m_histogram->record(Histogram::now()-m_start);
+	}
+};
+
+#endif // _Histogram_h_
@@ -0,0 +1,132 @@
+// Copyright 2003 "Gilles Degottex"
+
+// This file is part of "CppAddons"
+
+// "CppAddons" is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 2.1 of the License, or
+// (at your option) any later version.
+//
+// "CppAddons" is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+#include "RealTime.h"
+
+#include <errno.h>
+#include <string.h>
+#include <alloca.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <malloc.h>
+#include <sys/mman.h>
+#include <sstream>
+
+namespace RealTime
+{
+	bool setPriority(int priority)
+	{
+		struct sched_param param;
+		memset(&param, 0, sizeof(param));
+		param.sched_priority = priority;
+
+		int err = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+		if(err!=0)	{errno = err; return false;}
+
+		return true;
+	}
+
+	bool resetPriority()
+	{
+		struct sched_param param;
+		memset(&param, 0, sizeof(param));
+
+		int err = pthread_setschedparam(pthread_self(), SCHED_OTHER, &param);
+		if(err!=0)	{errno = err; return false;}
+
+		return true;
+	}
+
+	bool setAffinity(int cpu)
+	{
+		if(cpu<0 || cpu>=CPU_SETSIZE)	{errno = EINVAL; return false;}
+
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(cpu, &set);
+
+		int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+		if(err!=0)	{errno = err; return false;}
+
+		return true;
+	}
+
+	bool lockMemory()
+	{
+		if(mlockall(MCL_CURRENT|MCL_FUTURE)!=0)
+			return false;
+
+		mallopt(M_TRIM_THRESHOLD, -1);
+		mallopt(M_MMAP_MAX, 0);
+
+		return true;
+	}
+
+	bool setup(int priority, int cpu, std::string& status)
+	{
+		std::ostringstream out;
+		bool ok = true;
+
+		if(priority<=0)
+		{
+			resetPriority();
+			out << "normal scheduling";
+		}
+		else if(setPriority(priority))
+			out << "SCHED_FIFO " << priority;
+		else
+		{
+			out << "normal scheduling (SCHED_FIFO " << priority << ": " << strerror(errno) << ")";
+			ok = false;
+		}
+
+		if(cpu>=0)
+		{
+			if(setAffinity(cpu))
+				out << ", cpu " << cpu;
+			else
+			{
+				out << ", any cpu (cpu " << cpu << ": " << strerror(errno) << ")";
+				ok = false;
+			}
+		}
+
+		if(priority>0)
+			prefaultStack();
+
+		status = out.str();
+
+		return ok;
+	}
+
+	void prefault(void* p, size_t size)
+	{
+		volatile char* c = (volatile char*)p;
+		size_t page = size_t(sysconf(_SC_PAGESIZE));
+		for(size_t i=0; i<size; i+=page)
+			c[i] = c[i];
+	}
+
+	void prefaultStack(size_t size)
+	{
+		// volatile accesses, not optimized out
+		prefault(alloca(size), size);
+	}
+}
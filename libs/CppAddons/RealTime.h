@@ -0,0 +1,64 @@
+// Copyright 2003 "Gilles Degottex"
+
+// This file is part of "CppAddons"
+
+// "CppAddons" is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 2.1 of the License, or
+// (at your option) any later version.
+//
+// "CppAddons" is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+
+#ifndef _RealTime_h_
+#define _RealTime_h_
+
+#include <stddef.h>
+#include <string>
+
+//! real-time scheduling of the calling thread and memory locking (POSIX/Linux)
+/*!
+ * All the functions return false on failure with errno set, typically EPERM
+ * without the rights (RLIMIT_RTPRIO, RLIMIT_MEMLOCK or CAP_SYS_NICE): the
+ * caller may go on with the default behaviour.
+ */
+namespace RealTime
+{
+	//! SCHED_FIFO with the given priority [1;99]
+	bool setPriority(int priority);
+	//! back to SCHED_OTHER
+	bool resetPriority();
+	//! pin the calling thread on one cpu [0;nb cpus[
+	bool setAffinity(int cpu);
+
+	//! lock the current and future pages of the process in memory
+	/*!
+	 * The freed memory is also kept by malloc (no trimming, no mmap), so the
+	 * buffers allocated again and again don't page fault once warmed up.
+	 */
+	bool lockMemory();
+
+	//! set up the calling thread, falling back on the default scheduling when not permitted
+	/*!
+	 * \param priority SCHED_FIFO priority, 0 for the default scheduling
+	 * \param cpu the cpu to run on, -1 for any
+	 * \param status filled with a description of the resulting scheduling
+	 * \return false if one of the settings failed
+	 */
+	bool setup(int priority, int cpu, std::string& status);
+
+	//! touch size bytes of the stack of the calling thread, so it won't page fault later
+	void prefaultStack(size_t size=256*1024);
+	//! touch each page of [p;p+size[
+	void prefault(void* p, size_t size);
+}
+
+#endif // _RealTime_h_
@@ -0,0 +1,90 @@
+// Copyright 2003 "Gilles Degottex"
+
+// This file is part of "CppAddons"
+
+// "CppAddons" is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 2.1 of the License, or
+// (at your option) any later version.
+//
+// "CppAddons" is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+#ifndef _Simd_h_
+#define _Simd_h_
+
+#include <stdlib.h>
+#include <string.h>
+#include <new>
+#include <vector>
+
+//! portable SIMD with the GCC vector extensions
+/*!
+ * The vectors are 16 bytes wide: SSE2 on x86-64 and NEON on aarch64 without
+ * any -m flag. Wider vectors would change the ABI of these inline functions
+ * depending on -mavx. The kernels use several accumulators instead.
+ */
+namespace Simd
+{
+	enum {ALIGNMENT=32};
+
+	typedef double v2d __attribute__((vector_size(16)));
+	typedef float v4f __attribute__((vector_size(16)));
+	typedef long long v2l __attribute__((vector_size(16)));
+
+	enum {V2D_SIZE=2, V4F_SIZE=4};
+
+	//! round n up to a multiple of the vector size w
+	inline size_t padded(size_t n, size_t w)		{return (n+w-1)/w*w;}
+
+	//! unaligned load/store (the compiler makes them single instructions)
+	inline v2d load(const double* p)				{v2d v; memcpy(&v, p, sizeof(v)); return v;}
+	inline v4f load(const float* p)					{v4f v; memcpy(&v, p, sizeof(v)); return v;}
+	inline void store(double* p, const v2d& v)		{memcpy(p, &v, sizeof(v));}
+	inline void store(float* p, const v4f& v)		{memcpy(p, &v, sizeof(v));}
+
+	inline v2d splat(double a)						{v2d v = {a, a}; return v;}
+	inline v4f splat(float a)						{v4f v = {a, a, a, a}; return v;}
+
+	//! absolute values, by clearing the sign bits
+	inline v2d fabs(const v2d& v)					{v2l m = {0x7fffffffffffffffLL, 0x7fffffffffffffffLL}; return (v2d)((v2l)v & m);}
+
+	//! horizontal sum
+	inline double sum(const v2d& v)					{return v[0]+v[1];}
+	inline float sum(const v4f& v)					{return (v[0]+v[2]) + (v[1]+v[3]);}
+
+	//! STL allocator aligned on \ref ALIGNMENT, so the data can be accessed through v2d/v4f pointers
+	template<typename T>
+	struct aligned_allocator
+	{
+		typedef T value_type;
+
+		aligned_allocator() {}
+		template<typename U> aligned_allocator(const aligned_allocator<U>&) {}
+
+		T* allocate(size_t n)
+		{
+			void* p = NULL;
+			if(posix_memalign(&p, ALIGNMENT, padded(n*sizeof(T), ALIGNMENT))!=0)
+				throw std::bad_alloc();
+			return (T*)p;
+		}
+		void deallocate(T* p, size_t)				{free(p);}
+
+		template<typename U> bool operator==(const aligned_allocator<U>&) const	{return true;}
+		template<typename U> bool operator!=(const aligned_allocator<U>&) const	{return false;}
+	};
+
+	//! aligned vectors, use \ref padded sizes to access them by whole SIMD vectors
+	typedef std::vector<double, aligned_allocator<double> > vector_d;
+	typedef std::vector<float, aligned_allocator<float> > vector_f;
+}
+
+#endif // _Simd_h_
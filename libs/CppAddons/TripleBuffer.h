@@ -0,0 +1,70 @@
+// Copyright 2003 "Gilles Degottex"
+
+// This file is part of "CppAddons"
+
+// "CppAddons" is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 2.1 of the License, or
+// (at your option) any later version.
+//
+// "CppAddons" is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+
+#ifndef _TripleBuffer_h_
+#define _TripleBuffer_h_
+
+#include <atomic>
+
+//! lock-free publication of the latest value from one writer to one reader
+/*!
+ * The writer fills \ref back then \ref publish it, the reader calls
+ * \ref update then reads \ref front. Neither of them ever waits: there is
+ * always a spare buffer, and the reader only gets the latest published
+ * value (the older ones are dropped).
+ * The buffers are reused, so a T holding containers doesn't allocate once
+ * they are big enough.
+ */
+template<typename T>
+class TripleBuffer
+{
+	enum {INDEX=3, FRESH=4};
+
+	T m_buffers[3];
+	int m_back;							// writer only
+	std::atomic<int> m_middle;			// index of the spare buffer, FRESH if published since the last update
+	int m_front;						// reader only
+
+	TripleBuffer(const TripleBuffer&);
+	TripleBuffer& operator=(const TripleBuffer&);
+
+  public:
+	TripleBuffer() : m_back(0), m_middle(1), m_front(2)	{}
+
+	//! the buffer to fill, writer only
+	T& back()									{return m_buffers[m_back];}
+	//! make the back buffer the latest value, writer only
+	void publish()								{m_back = m_middle.exchange(m_back|FRESH, std::memory_order_acq_rel) & INDEX;}
+
+	//! get the latest published value, reader only
+	/*!
+	 * \return true if a new value was published since the last update
+	 */
+	bool update()
+	{
+		if(!(m_middle.load(std::memory_order_relaxed)&FRESH))	return false;
+		m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & INDEX;
+		return true;
+	}
+	//! the value got by the last \ref update, reader only
+	const T& front() const						{return m_buffers[m_front];}
+};
+
+#endif // _TripleBuffer_h_
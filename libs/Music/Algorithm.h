@@ -26,6 +26,7 @@
 #include <iostream>
 using namespace std;
 #include "Music.h"
+#include "Frame.h"
 
 namespace Music
 {
@@ -51,11 +52,21 @@ namespace Music
 		virtual int getSampleAlgoLatency() const =0;
 		virtual double getAlgoLatency() const				{return double(getSampleAlgoLatency())/GetSamplingRate();}
 
-		virtual void apply(const deque<double>& buff)=0;
+		virtual void apply(const Frame& frame)=0;
+		//! cheaply check that the recognized note is still playing
+		/*!
+		 * Used instead of \ref apply while a note sustains (see \ref OnsetDetector).
+		 * \return false if a full \ref apply is needed, otherwise the result is up to date
+		 */
+		virtual bool track(const Frame&)				{return false;}
+		//! a new note begins, the next \ref apply must not rely on the previous results
+		virtual void notifyOnset()							{}
 		virtual bool hasNoteRecognized() const =0;
+		//! how much the recognized note can be trusted [0;1]
+		virtual double getConfidence() const				{return hasNoteRecognized()?1.0:0.0;}
 		virtual int getFondamentalWaveLength() const		{return int(GetSamplingRate()/getFondamentalFreq());}
 		virtual double getFondamentalFreq() const			{return double(GetSamplingRate())/getFondamentalWaveLength();}
-		virtual double getFondamentalNote() const			{return f2hf(getFondamentalFreq());}
+		virtual double getFondamentalNote() const			{return fast_f2hf(getFondamentalFreq());}
 
 		virtual ~Algorithm();
 	};
@@ -89,7 +100,7 @@ namespace Music
 		virtual double getFondamentalNote() const			{return (hasNoteRecognized())?m_first_fond+GetSemitoneMin():Music::UNDEFINED_SEMITONE;}
 		bool isFondamentalNote(size_t i)					{return m_is_fondamental[i];}
 
-		virtual int getFondamentalWaveLength() const	{return int(GetSamplingRate()/h2f(getFondamentalNote()));}
+		virtual int getFondamentalWaveLength() const	{return int(fast_h2wl(getFondamentalNote()));}
 
 		virtual ~Transform(){}
 	};
@@ -41,13 +41,14 @@ namespace Music
 {
 	void AutocorrelationAlgo::init()
 	{
-		setMinMaxLength(int(GetSamplingRate()/h2f(GetSemitoneMax())), int(GetSamplingRate()/h2f(GetSemitoneMin())));
+		setMinMaxLength(int(fast_h2wl(GetSemitoneMax())), int(fast_h2wl(GetSemitoneMin())));
 	}
 
 	AutocorrelationAlgo::AutocorrelationAlgo(double noise_treshold)
 	: Algorithm(0.1)
 	, m_noise_threshold(noise_treshold)
 	, m_wave_length(0)
+	, m_confidence(0.0)
 	{
 		init();
 	}
@@ -55,26 +56,22 @@ namespace Music
 	//! return the average differance on the sample delimited by [0,size]
 	// - ne pas utiliser tout size
 	// - sauter des données
-	double diff(const deque<double>& buff, size_t size, size_t s)
+	static double diff(const Frame& frame, size_t size, size_t s)
 	{
-		double r = 0.0;
-		for(size_t i=0; i<size; i++)
-			r += abs(buff[i] - buff[i+s]);
-		return r / size;
+		return frame.amdf(s, size) / size;
 	}
 
-	void AutocorrelationAlgo::apply(const deque<double>& buff)
+	void AutocorrelationAlgo::apply(const Frame& frame)
 	{
-		if(buff.size()<2*m_max_length)
+		if(frame.size()<2*m_max_length)
 		{
-			cerr << "apply size " << buff.size() << " m_max_length " << m_max_length << endl;
+			cerr << "apply size " << frame.size() << " m_max_length " << m_max_length << endl;
 			m_wave_length = 0;
+			m_confidence = 0.0;
 			return;
 		}
 
-		double max_vol = 0.0;
-		for(size_t i=0; i<m_max_length; i++)
-			max_vol = max(max_vol, buff[i]);
+		double max_vol = frame.maximum(m_max_length);
 
 		// use a relative threshold
 		double threshold = m_noise_threshold*max_vol;
@@ -84,14 +81,14 @@ namespace Music
 		double r = 0.0;
 		size_t s;
 		for(s=m_min_length; r<=threshold && s<m_max_length; s++)
-			r = diff(buff, m_max_length, s);
+			r = diff(frame, m_max_length, s);
 
-		while((r=diff(buff, m_max_length, s+1))>threshold && s<m_max_length)
+		while(s<m_max_length && (r=diff(frame, m_max_length, s+1))>threshold)
 			s++;
 
 //	cerr << "s=" << s << " r=" << r << endl;
 		double old_r = r;
-		while(s+1<m_max_length && (r=diff(buff, m_max_length, s+1))<old_r)
+		while(s+1<m_max_length && (r=diff(frame, m_max_length, s+1))<old_r)
 		{
 //	cerr << "s=" << s << " r=" << r << endl;
 			s++;
@@ -103,6 +100,7 @@ namespace Music
 //	cerr << "absolute threshold=" << m_noise_threshold << " max volume="<<max_vol<<" relative threshold="<<threshold << " s="<<s << " m_max_length="<<m_max_length << endl;
 
 		m_wave_length = (s<m_max_length)?s:0;
+		m_confidence = (m_wave_length>0 && threshold>0.0)?max(0.0, 1.0-old_r/threshold):0.0;
 	}
 
 /*
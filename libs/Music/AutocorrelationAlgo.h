@@ -39,6 +39,7 @@ namespace Music
 		size_t m_max_length;
 
 		size_t m_wave_length;
+		double m_confidence;
 	
 		void init();
 		virtual void AFreqChanged()							{init();}
@@ -55,10 +56,12 @@ namespace Music
 		void setMinMaxLength(size_t min_length, size_t max_length)
 										{m_min_length=min_length; m_max_length=max_length;}
 
-		void apply(const deque<double>& buff);
+		void apply(const Frame& frame);
 
 		virtual bool hasNoteRecognized() const			{return m_wave_length>0;}
 		virtual int getFondamentalWaveLength() const	{return m_wave_length;}
+		//! 1-(difference at the period)/(noise threshold), 0 if no note
+		virtual double getConfidence() const			{return m_confidence;}
 
 		virtual ~AutocorrelationAlgo(){}
 	};
@@ -59,8 +59,8 @@ namespace Music
 
 	void BubbleAlgo::init()
 	{
-		m_min_length = int(GetSamplingRate()/h2f(GetSemitoneMax()));
-		m_max_length = int(GetSamplingRate()/h2f(GetSemitoneMin()));
+		m_min_length = int(fast_h2wl(GetSemitoneMax()));
+		m_max_length = int(fast_h2wl(GetSemitoneMin()));
 		setMinMaxLength(m_min_length, m_max_length);
 		m_bubbles.resize(m_max_length);
 		m_waves.resize(m_max_length);
@@ -73,7 +73,7 @@ namespace Music
 		double gauss_factor = 2.0;
 		size_t latency_factor = 2;
 
-		double u = Usefull(Win_Sinc(gauss_factor));
+		double u = GetWindowUsefull(WINDOW_SINC, gauss_factor);
 
 		for(size_t s=m_min_length; s<m_max_length; s++)
 		{
@@ -128,17 +128,17 @@ namespace Music
 	 * max is not stable enough
 	 * difficult to use conv because there is sound with fondamental with zero energy
 	 */
-	void BubbleAlgo::apply(const deque<double>& buff)
+	void BubbleAlgo::apply(const Frame& frame)
 	{
 		m_wave_length = 0;
 
-		if(buff.size()<m_waves.back().size())	return;
+		if(frame.size()<m_waves.back().size())	return;
+
+		const deque<double>& buff = frame.getBuffer();
 
 		LOG(cerr<<"BubbleAlgo::apply min_length="<<m_min_length<<" max_length="<<m_max_length<<endl;)
 
-		Type max_vol = 0.0;
-		for(size_t i=0; i<m_max_length; i++)
-			max_vol = max(Type(max_vol), Type(buff[i]));
+		Type max_vol = frame.maximum(m_max_length);
 
 		m_error_threshold = 0.33;
 		m_conv_threshold = 0.0;
@@ -78,7 +78,7 @@ namespace Music
 
 		virtual int getSampleAlgoLatency() const		{return 2*m_waves.back().size();}
 
-		void apply(const deque<double>& buff);
+		void apply(const Frame& frame);
 
 		virtual bool hasNoteRecognized() const			{return m_wave_length!=0;}
 		virtual int getFondamentalWaveLength() const	{return m_wave_length;}
@@ -0,0 +1,130 @@
+// Copyright 2004 "Gilles Degottex"
+
+// This file is part of "Music"
+
+// "Music" is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 2.1 of the License, or
+// (at your option) any later version.
+// 
+// "Music" is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+#include "BudgetController.h"
+
+#include <algorithm>
+#include <iostream>
+using namespace std;
+
+//#define MUSIC_DEBUG
+#ifdef MUSIC_DEBUG
+#define LOG(a)	a
+#else
+#define LOG(a)
+#endif
+
+namespace Music
+{
+	BudgetController::BudgetController(double high_load, double low_load)
+	: m_level(0)
+	, m_enabled(true)
+	, m_high_load(high_load)
+	, m_low_load(low_load)
+	, m_smoothing(0.1)
+	, m_degrade_hops(5)
+	, m_restore_hops(200)
+	, m_current_restore_hops(200)
+	, m_load(0.0)
+	, m_time(0.0)
+	, m_hop(0)
+	, m_restore_hop(-1)
+	, m_nb_over(0)
+	, m_nb_under(0)
+	, m_nb_settling(0)
+	, m_max_history(64)
+	{
+		m_levels.push_back("full");
+	}
+
+	void BudgetController::setLevels(const vector<string>& names)
+	{
+		m_levels = names;
+		if(m_levels.empty())
+			m_levels.push_back("full");
+		m_level = 0;
+		m_nb_over = m_nb_under = m_nb_settling = 0;
+	}
+
+	void BudgetController::change(int level)
+	{
+		LOG(cerr << "BudgetController::change " << m_levels[m_level] << " -> " << m_levels[level] << " load=" << m_load << endl;)
+
+		// a restored level which overloads again soon is retried later
+		if(level>m_level)
+		{
+			if(m_restore_hop>=0 && m_hop-m_restore_hop<m_current_restore_hops)
+				m_current_restore_hops = min(2*m_current_restore_hops, 16*m_restore_hops);
+			else
+				m_current_restore_hops = m_restore_hops;
+			m_restore_hop = -1;
+		}
+		else
+			m_restore_hop = m_hop;
+
+		m_history.push_front(Change(m_time, m_level, level, m_load));
+		if(m_history.size()>m_max_history)
+			m_history.pop_back();
+
+		m_level = level;
+		m_nb_over = m_nb_under = 0;
+		m_nb_settling = int(2.0/m_smoothing);
+	}
+
+	bool BudgetController::record(double analysis_time, double hop_time)
+	{
+		if(hop_time<=0.0)	return false;
+
+		m_time += hop_time;
+		m_hop++;
+		m_load = (1.0-m_smoothing)*m_load + m_smoothing*analysis_time/hop_time;
+
+		if(!m_enabled)	return false;
+
+		if(m_nb_settling>0)
+		{
+			m_nb_settling--;
+			return false;
+		}
+
+		m_nb_over = (m_load>m_high_load)?m_nb_over+1:0;
+		m_nb_under = (m_load<m_low_load)?m_nb_under+1:0;
+
+		if(m_nb_over>=m_degrade_hops && m_level+1<int(m_levels.size()))
+		{
+			change(m_level+1);
+			return true;
+		}
+		if(m_nb_under>=m_current_restore_hops && m_level>0)
+		{
+			change(m_level-1);
+			return true;
+		}
+
+		return false;
+	}
+
+	void BudgetController::reset()
+	{
+		if(m_level!=0)
+			change(0);
+		m_current_restore_hops = m_restore_hops;
+		m_restore_hop = -1;
+	}
+}
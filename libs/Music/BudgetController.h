@@ -0,0 +1,127 @@
+// Copyright 2004 "Gilles Degottex"
+
+// This file is part of "Music"
+
+// "Music" is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 2.1 of the License, or
+// (at your option) any later version.
+// 
+// "Music" is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+
+#ifndef _BudgetController_h_
+#define _BudgetController_h_
+
+#include <string>
+#include <vector>
+#include <deque>
+using namespace std;
+
+namespace Music
+{
+	//! keep the analysis within the real-time budget by degrading its settings
+	/*!
+	 * The caller gives, for each hop, the time spent by the analysis and the
+	 * duration of the analysed audio. Their ratio (the load) is smoothed;
+	 * - above the high load during the degrade hops, the next level is taken
+	 * - below the low load during the restore hops, the previous level is taken back
+	 * The levels are ordered from the best analysis (0) to the cheapest one,
+	 * the caller applies the settings of the level when \ref record returns true.
+	 * After a change, the smoothed load is given time to settle before any new decision.
+	 * The restore hops are doubled each time a restored level is degraded again
+	 * quickly, so that an overloaded level is not retried over and over.
+	 */
+	class BudgetController
+	{
+	  public:
+		//! a level change
+		struct Change
+		{
+			//! time of the change, in seconds of analysed audio
+			double time;
+			int from;
+			int to;
+			//! smoothed load leading to the change
+			double load;
+			Change(double t, int f, int o, double l) : time(t), from(f), to(o), load(l) {}
+		};
+
+	  private:
+		vector<string> m_levels;
+		int m_level;
+		bool m_enabled;
+
+		double m_high_load;
+		double m_low_load;
+		double m_smoothing;
+		int m_degrade_hops;
+		int m_restore_hops;
+		int m_current_restore_hops;
+
+		double m_load;
+		double m_time;
+		int m_hop;
+		int m_restore_hop;		// hop of the last restoration, -1 if degraded since
+		int m_nb_over;
+		int m_nb_under;
+		int m_nb_settling;		// hops left before the smoothed load reflects the new level
+
+		deque<Change> m_history;
+		size_t m_max_history;
+
+		void change(int level);
+
+	  public:
+		//! unique ctor
+		/*!
+		 * \param high_load load triggering a degradation ]0;oo[ (1 means the deadlines are missed)
+		 * \param low_load load allowing a restoration [0;high_load[
+		 */
+		BudgetController(double high_load=0.7, double low_load=0.3);
+
+		//! the levels names, from the best analysis to the cheapest one, back to level 0
+		void setLevels(const vector<string>& names);
+		size_t getNbLevels() const						{return m_levels.size();}
+		const string& getLevelName(int level) const		{return m_levels[level];}
+
+		//! if disabled, \ref record only measures the load, the level stays the same
+		void setEnabled(bool enabled)					{m_enabled=enabled;}
+		bool isEnabled() const							{return m_enabled;}
+
+		void setLoads(double high_load, double low_load)	{m_high_load=high_load; m_low_load=low_load;}
+		double getHighLoad() const						{return m_high_load;}
+		double getLowLoad() const						{return m_low_load;}
+		//! weight of the last hop in the smoothed load ]0;1]
+		void setSmoothing(double s)						{m_smoothing=s;}
+		//! number of consecutive hops before a degradation, and before a restoration [1;oo[
+		void setHops(int degrade_hops, int restore_hops)	{m_degrade_hops=degrade_hops; m_current_restore_hops=m_restore_hops=restore_hops;}
+
+		//! account one hop
+		/*!
+		 * \param analysis_time time spent by the analysis of the hop {seconds}
+		 * \param hop_time duration of the new audio of the hop {seconds}
+		 * \return true if the level changed
+		 */
+		bool record(double analysis_time, double hop_time);
+		//! back to level 0, keeping the history
+		void reset();
+
+		int getLevel() const							{return m_level;}
+		const string& getLevelName() const				{return m_levels[m_level];}
+		//! smoothed ratio of the analysis time over the audio duration
+		double getLoad() const							{return m_load;}
+		//! the last level changes, most recent first
+		const deque<Change>& getHistory() const			{return m_history;}
+	};
+}
+
+#endif // _BudgetController_h_
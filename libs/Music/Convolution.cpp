@@ -27,32 +27,81 @@ namespace Music
 {
 	Convolution::Convolution(double latency_factor, double gauss_factor, double ht)
 	: m_ht(ht)
-	, m_freq(h2f(m_ht))
+	, m_freq(fast_h2f(m_ht))
 	, m_latency_factor(latency_factor)
+	, m_gauss_factor(gauss_factor)
 	, m_duration(m_latency_factor/m_freq)
-	, m_wave(int(m_duration*GetSamplingRate()))
+	, m_wave_re(int(m_duration*GetSamplingRate()))
+	, m_wave_im(m_wave_re.size())
 	{
 //		cerr << "Convolution::Convolution " << ht << endl;
 		double c = - 2.0*Math::Pi * m_freq / GetSamplingRate();
 
-		double u = Usefull(Win_Sinc(gauss_factor));
+		double u = GetWindowUsefull(WINDOW_SINC, gauss_factor);
 
-		for(size_t j=0; j<m_wave.size(); j++)
-			m_wave[j] = exp(complex<double>(0.0, c*j))*double(2.0/m_wave.size()) * win_sinc(j/double(m_wave.size()), gauss_factor)/u;
-		// 		m_wave[j] = exp(complex<double>(0.0, c*j))*double(2.0*Math::Pi/m_wave.size()) * win_sinc(j/double(m_wave.size()), win_factor)/u;
+		for(size_t j=0; j<size(); j++)
+		{
+			complex<double> w = exp(complex<double>(0.0, c*j))*double(2.0/size()) * win_sinc(j/double(size()), gauss_factor)/u;
+			m_wave_re[j] = float(w.real());
+			m_wave_im[j] = float(w.imag());
+		}
+	}
+
+	void Convolution::ToFloats(const deque<double>& buff, size_t n, Simd::vector_f& out)
+	{
+		out.resize(n);
+		for(size_t i=0; i<n; i++)
+			out[i] = float(buff[i]);
 	}
 
 	void Convolution::apply(const deque<double>& buff, int start)
 	{
-		if(buff.size()-start < m_wave.size())
-			m_formant = complex<double>(0.0,0.0);
-		else
+		if(buff.size()-start < size())
 		{
 			m_formant = complex<double>(0.0,0.0);
+			return;
+		}
 
-			for(size_t i=0; i<m_wave.size(); i++)
-				m_formant += m_wave[i]*buff[i+start];
+		static thread_local Simd::vector_f s_buff;
+		s_buff.resize(size());
+		for(size_t i=0; i<size(); i++)
+			s_buff[i] = float(buff[i+start]);
+
+		apply(s_buff.data(), s_buff.size());
+	}
+
+	void Convolution::apply(const float* buff, size_t n)
+	{
+		using namespace Simd;
+
+		m_formant = complex<double>(0.0,0.0);
+		if(n<size())	return;
+
+		const float* re = &m_wave_re[0];
+		const float* im = &m_wave_im[0];
+
+		// two accumulators by part against the add latency
+		v4f re0 = splat(0.0f), re1 = splat(0.0f);
+		v4f im0 = splat(0.0f), im1 = splat(0.0f);
+		size_t i=0;
+		for(; i+2*V4F_SIZE<=size(); i+=2*V4F_SIZE)
+		{
+			v4f b0 = load(buff+i);
+			v4f b1 = load(buff+i+V4F_SIZE);
+			re0 += *(const v4f*)(re+i) * b0;
+			re1 += *(const v4f*)(re+i+V4F_SIZE) * b1;
+			im0 += *(const v4f*)(im+i) * b0;
+			im1 += *(const v4f*)(im+i+V4F_SIZE) * b1;
+		}
+		double r = sum(re0+re1);
+		double m = sum(im0+im1);
+		for(; i<size(); i++)
+		{
+			r += re[i]*buff[i];
+			m += im[i]*buff[i];
 		}
+
+		m_formant = complex<double>(r, m);
 	}
 
 #if 0
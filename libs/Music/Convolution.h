@@ -24,6 +24,7 @@
 #include <deque>
 #include <complex>
 using namespace std;
+#include <CppAddons/Simd.h>
 
 namespace Music
 {
@@ -36,11 +37,14 @@ namespace Music
 		const double m_freq;
 		//! latency factor, used for statistical purpose (40.0)
 		const double m_latency_factor;
+		//! the factor of the window fonction
+		const double m_gauss_factor;
 		//! duration in seconds
 		const double m_duration;
 
-		//! the wave: the signal is convolued with
-		vector< complex<double> > m_wave;
+		//! the wave: the signal is convolued with, real and imaginary parts
+		Simd::vector_f m_wave_re;
+		Simd::vector_f m_wave_im;
 
 		//! computed formant
 		complex<double> m_formant;
@@ -56,10 +60,17 @@ namespace Music
 		Convolution(double latency_factor, double gauss_factor, double ht);
 
 		//! return the size of the analyse (the algorithmical N)
-		size_t size()	{return m_wave.size();}
+		size_t size()	{return m_wave_re.size();}
 
 		//! compute a convolution
 		void apply(const deque<double>& buff, int start=0);
+		//! compute a convolution on contiguous samples (most recent first)
+		/*! \param n number of samples available in buff
+		 */
+		void apply(const float* buff, size_t n);
+
+		//! copy the n first samples of buff into out, for \ref apply(const float*, size_t)
+		static void ToFloats(const deque<double>& buff, size_t n, Simd::vector_f& out);
 	};
 }
 
@@ -19,13 +19,15 @@
 
 #include "Correlation.h"
 
+#include <cmath>
 #include <iostream>
 #include "Music.h"
+#include "Frame.h"
 using namespace Music;
 
 Correlation::Correlation(double latency_factor, int ht)
 : m_ht(ht)
-, m_freq(h2f(m_ht))
+, m_freq(fast_h2f(m_ht))
 , m_s(size_t(GetSamplingRate()/m_freq))
 , m_latency_factor(latency_factor)
 {
@@ -44,12 +46,19 @@ void Correlation::receive(const deque<double>& buff, size_t start)
 		m_error += abs(buff[start+i] - buff[start+i+m_s]);
 }
 
+void Correlation::receive(const Frame& frame, size_t start)
+{
+	if(frame.size()<start+(m_latency_factor+1)*m_s)	return;
+
+	m_error = frame.amdf(m_s, size_t(ceil(m_latency_factor*m_s)), start);
+}
+
 RangedCorrelation::RangedCorrelation(double pitch_tolerance, double latency_factor, int ht)
 : m_ht(ht)
-, m_freq(h2f(m_ht))
+, m_freq(fast_h2f(m_ht))
 , m_pitch_tolerance(pitch_tolerance)
-, m_smin(size_t(GetSamplingRate()/(m_freq + m_pitch_tolerance*(h2f(m_ht+1)-m_freq))))
-, m_smax(size_t(GetSamplingRate()/(m_freq + m_pitch_tolerance*(h2f(m_ht-1)-m_freq))))
+, m_smin(size_t(GetSamplingRate()/(m_freq + m_pitch_tolerance*(fast_h2f(m_ht+1)-m_freq))))
+, m_smax(size_t(GetSamplingRate()/(m_freq + m_pitch_tolerance*(fast_h2f(m_ht-1)-m_freq))))
 , m_latency_factor(latency_factor)
 {
 	m_error = 0.0;
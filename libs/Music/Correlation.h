@@ -25,6 +25,8 @@ using namespace std;
 
 namespace Music
 {
+	class Frame;
+
 	//! do a correlation with a specific wave-length of a desired note
 	struct Correlation
 	{
@@ -48,6 +50,8 @@ namespace Music
 
 		//! compute the error
 		void receive(const deque<double>& buff, size_t start=0);
+		//! same as above with the memoised \ref Frame::amdf
+		void receive(const Frame& frame, size_t start=0);
 
 		//! computed error for the desired semi-tone (m_ht)
 		double m_error;
@@ -0,0 +1,200 @@
+// Copyright 2004 "Gilles Degottex"
+
+// This file is part of "Music"
+
+// "Music" is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 2.1 of the License, or
+// (at your option) any later version.
+// 
+// "Music" is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+#include "EnsembleAlgo.h"
+
+#include <cmath>
+#include <map>
+#include <iostream>
+using namespace std;
+
+//#define MUSIC_DEBUG
+#ifdef MUSIC_DEBUG
+#define LOG(a)	a
+#else
+#define LOG(a)
+#endif
+
+namespace Music
+{
+	EnsembleAlgo::EnsembleAlgo()
+	: Algorithm(0.0)
+	, m_min_agreement(0.0)
+	, m_frame(NULL)
+	, m_job_track(false)
+	, m_generation(0)
+	, m_nb_running(0)
+	, m_quit(false)
+	, m_ht(UNDEFINED_SEMITONE)
+	, m_confidence(0.0)
+	{
+	}
+
+	void EnsembleAlgo::add(Algorithm* algo, double weight)
+	{
+		m_members.push_back(Member(algo, weight));
+
+		if(m_members.size()>1)
+			m_workers.push_back(thread(&EnsembleAlgo::work, this, m_members.size()-1));
+	}
+
+	int EnsembleAlgo::getSampleAlgoLatency() const
+	{
+		int latency = 0;
+		for(size_t m=0; m<m_members.size(); m++)
+			latency = max(latency, m_members[m].algo->getSampleAlgoLatency());
+
+		return latency;
+	}
+
+	void EnsembleAlgo::run(size_t m)
+	{
+		Member& member = m_members[m];
+
+		if(!m_job_track || !member.algo->track(*m_frame))
+			member.algo->apply(*m_frame);
+
+		member.note = member.algo->hasNoteRecognized();
+		if(member.note)
+		{
+			member.ht = int(floor(member.algo->getFondamentalNote()+0.5));
+			member.confidence = member.algo->getConfidence();
+		}
+	}
+
+	void EnsembleAlgo::work(size_t m)
+	{
+		unsigned int generation = 0;
+
+		unique_lock<mutex> lock(m_mutex);
+		while(true)
+		{
+			m_start_cond.wait(lock, [&]{return m_quit || m_generation!=generation;});
+			if(m_quit)	return;
+			generation = m_generation;
+
+			lock.unlock();
+			run(m);
+			lock.lock();
+
+			if(--m_nb_running==0)
+				m_done_cond.notify_one();
+		}
+	}
+
+	void EnsembleAlgo::dispatch(const Frame& frame, bool track)
+	{
+		// convert the samples once, before the members share the frame
+		frame.prepare(getSampleAlgoLatency());
+
+		{
+			lock_guard<mutex> lock(m_mutex);
+			m_frame = &frame;
+			m_job_track = track;
+			m_nb_running = int(m_workers.size());
+			m_generation++;
+		}
+		m_start_cond.notify_all();
+
+		if(!m_members.empty())
+			run(0);
+
+		unique_lock<mutex> lock(m_mutex);
+		m_done_cond.wait(lock, [&]{return m_nb_running==0;});
+		m_frame = NULL;
+	}
+
+	void EnsembleAlgo::vote()
+	{
+		map<int, double> scores;
+		double total = 0.0;
+		for(size_t m=0; m<m_members.size(); m++)
+		{
+			const Member& member = m_members[m];
+			total += member.weight;
+			if(member.note && member.ht>=GetSemitoneMin() && member.ht<=GetSemitoneMax())
+				scores[member.ht] += member.weight*member.confidence;
+		}
+
+		// the first members win the ties
+		m_ht = UNDEFINED_SEMITONE;
+		m_confidence = 0.0;
+		for(size_t m=0; m<m_members.size(); m++)
+		{
+			const Member& member = m_members[m];
+			if(scores.count(member.ht) && scores[member.ht]>m_confidence)
+			{
+				m_ht = member.ht;
+				m_confidence = scores[member.ht];
+			}
+		}
+		if(total>0.0)
+			m_confidence /= total;
+
+		if(m_ht!=UNDEFINED_SEMITONE && (m_confidence<=0.0 || m_confidence<m_min_agreement))
+		{
+			m_ht = UNDEFINED_SEMITONE;
+			m_confidence = 0.0;
+		}
+
+		LOG(cerr << "EnsembleAlgo::vote " << m_ht << " " << m_confidence << endl;)
+	}
+
+	void EnsembleAlgo::apply(const Frame& frame)
+	{
+		dispatch(frame, false);
+		vote();
+	}
+
+	bool EnsembleAlgo::track(const Frame& frame)
+	{
+		if(!hasNoteRecognized())
+			return false;
+
+		dispatch(frame, true);
+		vote();
+
+		// as for the other algorithms, false if the note is lost
+		return hasNoteRecognized();
+	}
+
+	void EnsembleAlgo::notifyOnset()
+	{
+		for(size_t m=0; m<m_members.size(); m++)
+			m_members[m].algo->notifyOnset();
+	}
+
+	void EnsembleAlgo::stopWorkers()
+	{
+		{
+			lock_guard<mutex> lock(m_mutex);
+			m_quit = true;
+		}
+		m_start_cond.notify_all();
+
+		for(size_t w=0; w<m_workers.size(); w++)
+			m_workers[w].join();
+		m_workers.clear();
+	}
+
+	EnsembleAlgo::~EnsembleAlgo()
+	{
+		stopWorkers();
+	}
+}
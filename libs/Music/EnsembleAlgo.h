@@ -0,0 +1,115 @@
+// Copyright 2004 "Gilles Degottex"
+
+// This file is part of "Music"
+
+// "Music" is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 2.1 of the License, or
+// (at your option) any later version.
+// 
+// "Music" is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+#ifndef _EnsembleAlgo_h_
+#define _EnsembleAlgo_h_
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+using namespace std;
+#include "Algorithm.h"
+
+namespace Music
+{
+	//! run several algorithms concurrently on the same frame and vote
+	/*!
+	 * Each member runs in its own worker thread (the first one in the calling
+	 * thread), so the frame is analysed in the time of the slowest member.
+	 * Each member recognizing a note votes for its nearest semi-tone with its
+	 * weight times its \ref Algorithm::getConfidence; the semi-tone with the
+	 * best score is recognized if its score reaches the agreement ratio of
+	 * the total weight.
+	 * The members are not owned by the ensemble and must not be applied
+	 * elsewhere meanwhile.
+	 */
+	class EnsembleAlgo : public Algorithm
+	{
+		struct Member
+		{
+			Algorithm* algo;
+			double weight;
+			bool note;
+			int ht;
+			double confidence;
+			Member(Algorithm* a, double w) : algo(a), weight(w), note(false), ht(UNDEFINED_SEMITONE), confidence(0.0) {}
+		};
+		vector<Member> m_members;
+		double m_min_agreement;
+
+		// the workers, m_workers[i] runs m_members[i+1]
+		vector<thread> m_workers;
+		mutex m_mutex;
+		condition_variable m_start_cond;
+		condition_variable m_done_cond;
+		const Frame* m_frame;
+		bool m_job_track;
+		unsigned int m_generation;
+		int m_nb_running;
+		bool m_quit;
+
+		int m_ht;
+		double m_confidence;
+
+		void work(size_t m);
+		void run(size_t m);
+		void dispatch(const Frame& frame, bool track);
+		void vote();
+		void stopWorkers();
+
+		virtual void AFreqChanged()							{}
+		virtual void samplingRateChanged()					{}
+		virtual void semitoneBoundsChanged()				{}
+
+	  public:
+		EnsembleAlgo();
+
+		//! add an algorithm, before the first \ref apply
+		/*!
+		 * \param weight weight of its votes ]0;oo[
+		 */
+		void add(Algorithm* algo, double weight=1.0);
+		size_t getNbMembers() const							{return m_members.size();}
+		Algorithm* getMember(size_t m) const				{return m_members[m].algo;}
+		//! the semi-tone voted by the member m, UNDEFINED_SEMITONE if none
+		int getMemberNote(size_t m) const					{return m_members[m].note?m_members[m].ht:UNDEFINED_SEMITONE;}
+
+		//! minimal ratio of the total weight the recognized note must get [0;1]
+		void setMinAgreement(double r)						{m_min_agreement = r;}
+		double getMinAgreement() const						{return m_min_agreement;}
+
+		virtual int getSampleAlgoLatency() const;
+
+		virtual void apply(const Frame& frame);
+		//! the members track their note, those which can't are applied
+		virtual bool track(const Frame& frame);
+		virtual void notifyOnset();
+		virtual bool hasNoteRecognized() const				{return m_ht!=UNDEFINED_SEMITONE;}
+		//! score of the recognized note over the total weight
+		virtual double getConfidence() const				{return m_confidence;}
+		virtual double getFondamentalNote() const			{return m_ht;}
+		virtual double getFondamentalFreq() const			{return h2f(m_ht);}
+		virtual int getFondamentalWaveLength() const		{return int(fast_h2wl(m_ht));}
+
+		virtual ~EnsembleAlgo();
+	};
+}
+
+#endif // _EnsembleAlgo_h_
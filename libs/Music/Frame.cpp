@@ -0,0 +1,156 @@
+// Copyright 2004 "Gilles Degottex"
+
+// This file is part of "Music"
+
+// "Music" is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 2.1 of the License, or
+// (at your option) any later version.
+// 
+// "Music" is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+
+#include "Frame.h"
+
+#include <cassert>
+#include <cmath>
+#include <algorithm>
+using namespace std;
+
+namespace Music
+{
+	double AMDF(const double* x, size_t lag, size_t n)
+	{
+		using namespace Simd;
+
+		const double* a = x;
+		const double* b = x+lag;
+
+		v2d acc0 = splat(0.0);
+		v2d acc1 = splat(0.0);
+		size_t i=0;
+		for(; i+2*V2D_SIZE<=n; i+=2*V2D_SIZE)
+		{
+			acc0 += Simd::fabs(load(a+i) - load(b+i));
+			acc1 += Simd::fabs(load(a+i+V2D_SIZE) - load(b+i+V2D_SIZE));
+		}
+		double err = sum(acc0+acc1);
+		for(; i<n; i++)
+			err += abs(a[i] - b[i]);
+
+		return err;
+	}
+
+	Frame::Frame(const deque<double>& buff, size_t max_size)
+	: m_buff(buff)
+	, m_size(min(buff.size(), max_size))
+	, m_ups_scanned(0)
+	{
+		m_samples.reserve(m_size);
+		m_peak.reserve(m_size);
+		m_max.reserve(m_size);
+		m_energy.reserve(m_size);
+	}
+
+	void Frame::extend(size_t n) const
+	{
+		n = min(n, m_size);
+		double peak = m_peak.empty()?0.0:m_peak.back();
+		double maximum = m_max.empty()?0.0:m_max.back();
+		double energy = m_energy.empty()?0.0:m_energy.back();
+		for(size_t i=m_samples.size(); i<n; i++)
+		{
+			double v = m_buff[i];
+			m_samples.push_back(v);
+			peak = max(peak, abs(v));
+			maximum = max(maximum, v);
+			energy += v*v;
+			m_peak.push_back(peak);
+			m_max.push_back(maximum);
+			m_energy.push_back(energy);
+		}
+	}
+
+	void Frame::prepare(size_t n) const
+	{
+		lock_guard<mutex> lock(m_mutex);
+		extend(n);
+	}
+	const double* Frame::samples(size_t n) const
+	{
+		lock_guard<mutex> lock(m_mutex);
+		extend(n);
+		return m_samples.data();
+	}
+	const float* Frame::floats(size_t n) const
+	{
+		lock_guard<mutex> lock(m_mutex);
+		n = min(n, m_size);
+		if(m_floats.size()<n)
+		{
+			extend(n);
+			if(m_floats.capacity()<m_size)
+				m_floats.reserve(m_size);
+			for(size_t i=m_floats.size(); i<n; i++)
+				m_floats.push_back(float(m_samples[i]));
+		}
+		return m_floats.data();
+	}
+
+	double Frame::peak(size_t n) const
+	{
+		lock_guard<mutex> lock(m_mutex);
+		n = min(n, m_size);
+		if(n==0)	return 0.0;
+		extend(n);
+		return m_peak[n-1];
+	}
+	double Frame::maximum(size_t n) const
+	{
+		lock_guard<mutex> lock(m_mutex);
+		n = min(n, m_size);
+		if(n==0)	return 0.0;
+		extend(n);
+		return m_max[n-1];
+	}
+	double Frame::rms(size_t n) const
+	{
+		lock_guard<mutex> lock(m_mutex);
+		n = min(n, m_size);
+		if(n==0)	return 0.0;
+		extend(n);
+		return sqrt(m_energy[n-1]/n);
+	}
+
+	vector<size_t> Frame::upCrossings(size_t n) const
+	{
+		lock_guard<mutex> lock(m_mutex);
+		while(m_ups.size()<n && m_ups_scanned+1<m_size)
+		{
+			// by blocks, as the crossings are usually found early
+			size_t end = min(m_size, max(m_ups_scanned+1024, 2*m_samples.size()));
+			extend(end);
+			for(; m_ups.size()<n && m_ups_scanned+1<end; m_ups_scanned++)
+				if(m_samples[m_ups_scanned]<=0 && m_samples[m_ups_scanned+1]>0)
+					m_ups.push_back(m_ups_scanned);
+		}
+
+		return vector<size_t>(m_ups.begin(), m_ups.begin()+min(n, m_ups.size()));
+	}
+
+	double Frame::amdf(size_t lag, size_t n, size_t start) const
+	{
+		assert(start+lag+n<=m_size);
+
+		// computed unlocked, the samples up to start+lag+n do not move anymore
+		return AMDF(samples(start+lag+n)+start, lag, n);
+	}
+}
@@ -0,0 +1,108 @@
+// Copyright 2004 "Gilles Degottex"
+
+// This file is part of "Music"
+
+// "Music" is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 2.1 of the License, or
+// (at your option) any later version.
+// 
+// "Music" is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+
+#ifndef _Frame_h_
+#define _Frame_h_
+
+#include <deque>
+#include <vector>
+#include <mutex>
+using namespace std;
+#include <CppAddons/Simd.h>
+
+namespace Music
+{
+	//! average magnitude difference: sum of |x[i]-x[i+lag]| for i in [0;n[
+	double AMDF(const double* x, size_t lag, size_t n);
+
+	//! the features of one analysis frame, shared by all the algorithms
+	/*!
+	 * Built once by hop on the samples queue (most recent sample first) and
+	 * given to each \ref Algorithm::apply. The prefix features (samples,
+	 * volume, energy, zero crossings) are computed on demand and memoised:
+	 * the algorithms asking for them compute them only once by hop.
+	 * The queue must not change during the life of the frame.
+	 * The accessors can be called from several threads.
+	 */
+	class Frame
+	{
+		const deque<double>& m_buff;
+		size_t m_size;
+
+		mutable mutex m_mutex;
+
+		// contiguous copies, reserved to m_size so the given pointers stay valid
+		mutable Simd::vector_d m_samples;
+		mutable Simd::vector_f m_floats;
+		// m_peak[i] is the max of |x| on [0;i], m_max[i] the max of x and
+		// m_energy[i] the sum of x^2
+		mutable vector<double> m_peak;
+		mutable vector<double> m_max;
+		mutable vector<double> m_energy;
+		// the upward zero crossings found on [0;m_ups_scanned[
+		mutable vector<size_t> m_ups;
+		mutable size_t m_ups_scanned;
+
+		//! convert the samples up to n, m_mutex locked
+		void extend(size_t n) const;
+
+		Frame(const Frame&);
+		Frame& operator=(const Frame&);
+
+	  public:
+		//! unique ctor
+		/*!
+		 * \param buff the samples queue, most recent sample first
+		 * \param max_size the number of samples of buff used at most (all by default)
+		 */
+		Frame(const deque<double>& buff, size_t max_size=size_t(-1));
+
+		const deque<double>& getBuffer() const			{return m_buff;}
+		//! the number of usable samples
+		size_t size() const								{return m_size;}
+
+		//! convert the n most recent samples now
+		/*!
+		 * Before sharing the frame between threads, so they don't wait for
+		 * each other on the conversion.
+		 */
+		void prepare(size_t n) const;
+		//! the n most recent samples, contiguous
+		const double* samples(size_t n) const;
+		//! the n most recent samples, contiguous, as floats
+		const float* floats(size_t n) const;
+
+		//! maximal absolute value of the n most recent samples
+		double peak(size_t n) const;
+		//! maximal value of the n most recent samples (0 at least)
+		double maximum(size_t n) const;
+		//! root mean square of the n most recent samples
+		double rms(size_t n) const;
+		//! the first n upward zero crossings (the i where x[i]<=0 and x[i+1]>0)
+		vector<size_t> upCrossings(size_t n) const;
+		//! \ref AMDF of the samples from start, start+lag+n<=size()
+		/*!
+		 * Not memoised, no two callers ask for the same lag on the same span.
+		 */
+		double amdf(size_t lag, size_t n, size_t start=0) const;
+	};
+}
+
+#endif // _Frame_h_
@@ -33,15 +33,28 @@ namespace Music
 	{
 		if(GetSamplingRate()<=0)	return;
 
-		for(size_t h=0; h<size(); h++)
-			if(m_convolutions[h]!=NULL)
-				delete m_convolutions[h];
-
-		m_components.resize(GetNbSemitones());
-		m_convolutions.resize(GetNbSemitones());
-		m_formants.resize(GetNbSemitones());
-		for(size_t h=0; h<size(); h++)
-			m_convolutions[h] = new Convolution(m_latency_factor, m_gauss_factor, int(h)+GetSemitoneMin());
+		double latency_factor = m_latency_factor;
+		double gauss_factor = m_gauss_factor;
+		m_bank.build(
+			[latency_factor, gauss_factor](int ht){return new Convolution(latency_factor, gauss_factor, ht);},
+			[latency_factor, gauss_factor](const Convolution& conv){return conv.m_latency_factor==latency_factor && conv.m_gauss_factor==gauss_factor;});
+	}
+	void SingleResConvolutionTransform::adopt()
+	{
+		if(m_bank.adopt(m_convolutions))
+		{
+			m_components.resize(m_convolutions.size());
+			m_formants.resize(m_convolutions.size());
+			m_is_fondamental.resize(m_convolutions.size());
+			m_first_fond = -1;
+		}
+	}
+	const float* SingleResConvolutionTransform::toFloats(const Frame& frame, size_t& n)
+	{
+		n = 0;
+		if(!m_convolutions.empty())
+			n = min(frame.size(), m_convolutions[0]->size());
+		return frame.floats(n);
 	}
 
 	SingleResConvolutionTransform::SingleResConvolutionTransform(double latency_factor, double gauss_factor)
@@ -49,27 +62,22 @@ namespace Music
 	, m_latency_factor(latency_factor)
 	, m_gauss_factor(gauss_factor)
 	{
-		m_convolutions.resize(size());
-		m_formants.resize(size());
-		for(size_t h=0; h<size(); h++)
-			m_convolutions[h] = NULL;
 		init();
+		adopt();
 	}
-	void SingleResConvolutionTransform::apply(const deque<double>& buff)
+	void SingleResConvolutionTransform::apply(const Frame& frame)
 	{
+		adopt();
+		size_t n;
+		const float* buff = toFloats(frame, n);
 		for(size_t h=0; h<size(); h++)
 		{
 			m_is_fondamental[h] = false;
-			m_convolutions[h]->apply(buff);
+			m_convolutions[h]->apply(buff, n);
 			m_formants[h] = m_convolutions[h]->m_formant;
 			m_components[h] = normm(m_formants[h]);
 		}
 	}
-	SingleResConvolutionTransform::~SingleResConvolutionTransform()
-	{
-		for(size_t i=0; i<m_convolutions.size(); i++)
-			delete m_convolutions[i];
-	}
 
 // NeuralNetGaussAlgo
 	void NeuralNetGaussAlgo::init()
@@ -84,16 +92,21 @@ namespace Music
 	: SingleResConvolutionTransform(latency_factor, gauss_factor)
 	{
 		init();
+		adopt();
 	}
 
-	void NeuralNetGaussAlgo::apply(const deque<double>& buff)
+	void NeuralNetGaussAlgo::apply(const Frame& frame)
 	{
 //		cerr << "NeuralNetGaussAlgo::apply " << m_components_treshold << endl;
 
+		adopt();
+		size_t n;
+		const float* buff = toFloats(frame, n);
+
 		m_components_max = 0.0;
 		for(size_t h=0; h<size(); h++)
 		{
-			m_convolutions[h]->apply(buff);
+			m_convolutions[h]->apply(buff, n);
 			m_formants[h] = m_convolutions[h]->m_formant;
 			m_components[h] = normm(m_formants[h]);
 			m_components_max = max(m_components_max, m_components[h]);
@@ -120,14 +133,15 @@ namespace Music
 	MonophonicAlgo::MonophonicAlgo(double latency_factor, double gauss_factor)
 	: SingleResConvolutionTransform(latency_factor, gauss_factor)
 	{
-		init();
 	}
 	int MonophonicAlgo::getSampleAlgoLatency() const
 	{
 		return m_convolutions[0]->size();
 	}
-	void MonophonicAlgo::apply(const deque<double>& buff)
+	void MonophonicAlgo::apply(const Frame& frame)
 	{
+		adopt();
+
 		for(size_t h=0; h<m_is_fondamental.size(); h++)
 			m_is_fondamental[h] = false;
 
@@ -138,16 +152,15 @@ namespace Music
 //		cout << "buff size=" << buff.size() << " size=" << m_convolutions[m_convolutions.size()-1]->size() << endl;
 
 		int h;
-		for(h=size()-1; h>=0 && buff.size()>=m_convolutions[h]->size(); h--)
+		// the windows are nested: the frame converts the samples as they grow
+		for(h=size()-1; h>=0 && frame.size()>=m_convolutions[h]->size(); h--)
 		{
-			size_t i=0;
-			if(h!=int(size())-1) i=m_convolutions[h+1]->size();
-			for(; i<m_convolutions[h]->size(); i++)	
-				m_volume_max = max(m_volume_max, abs(buff[i]));
+			size_t n = m_convolutions[h]->size();
+			m_volume_max = frame.peak(n);
 
 			if(m_volume_max > getVolumeTreshold())
 			{
-				m_convolutions[h]->apply(buff);
+				m_convolutions[h]->apply(frame.floats(n), n);
 
 				double formant_mod = normm(m_convolutions[h]->m_formant);
 
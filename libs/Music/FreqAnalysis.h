@@ -30,6 +30,7 @@ using namespace std;
 #include "Music.h"
 #include "Algorithm.h"
 #include "Convolution.h"
+#include "SemitoneBank.h"
 
 namespace Music
 {
@@ -38,8 +39,15 @@ namespace Music
 	 */
 	class SingleResConvolutionTransform : public Transform
 	{
+		SemitoneBank<Convolution> m_bank;
+
 	  protected:
+		//! rebuild the convolutions, they are used from the next \ref apply
 		virtual void init();
+		//! to call at the beginning of \ref apply
+		void adopt();
+		//! the samples used by the longest convolution, as floats
+		const float* toFloats(const Frame& frame, size_t& n);
 		virtual void AFreqChanged()							{init();}
 		virtual void samplingRateChanged()					{init();}
 		virtual void semitoneBoundsChanged()				{init();}
@@ -47,6 +55,7 @@ namespace Music
 		double m_gauss_factor;
 
 	  public:
+		//! the convolutions (owned by m_bank)
 		vector<Convolution*> m_convolutions;
 
 		SingleResConvolutionTransform(double latency_factor, double gauss_factor);
@@ -57,9 +66,9 @@ namespace Music
 		void setGaussFactor(double g)						{m_gauss_factor=g; init();}
 		double getGaussFactor()								{return m_gauss_factor;}
 
-		virtual void apply(const deque<double>& buff);
+		virtual void apply(const Frame& frame);
 
-		virtual ~SingleResConvolutionTransform();
+		virtual ~SingleResConvolutionTransform()			{}
 	};
 
 	/*! extraction des fondamentales avec un rsaux de neurones
@@ -76,7 +85,7 @@ namespace Music
 		
 		virtual int getSampleAlgoLatency() const {return 0;}
 
-		virtual void apply(const deque<double>& buff);
+		virtual void apply(const Frame& frame);
 
 		virtual ~NeuralNetGaussAlgo();
 	};
@@ -98,7 +107,7 @@ namespace Music
 		inline double getDominantTreshold()			{return m_dominant_treshold;}
 		inline void setDominantTreshold(double t)	{m_dominant_treshold=t;}
 
-		virtual void apply(const deque<double>& buff);
+		virtual void apply(const Frame& frame);
 
 		virtual ~MonophonicAlgo()					{}
 	};
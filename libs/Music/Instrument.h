@@ -28,6 +28,7 @@ using namespace std;
 #include <CppAddons/Math.h>
 using namespace Math;
 #include "Music.h"
+#include "Oscillator.h"
 
 namespace Music
 {
@@ -44,6 +45,13 @@ struct Instrument
 
 	virtual double gen_value(int k, double phase=0.0)=0;
 
+	//! add ampl times the n next values of \ref gen_value to out
+	virtual void gen_values(int k, double phase, double ampl, double* out, size_t n)
+	{
+		for(size_t j=0; j<n; j++)
+			out[j] += ampl*gen_value(k, phase);
+	}
+
 	virtual ~Instrument(){}
 };
 
@@ -58,6 +66,7 @@ struct HarmInstrument : Instrument
 	vector< Math::polar<double> > m_freqs;
 	int m_base_ht;
 	double m_base_freq;
+	OscillatorBank m_bank;
 
 	HarmInstrument(int dataBySecond, double AFreq, int nb_harm=int((rand()/RAND_MAX)*MAX_NB_HARM), int min_rdm_ht=-12, int max_rdm_ht=12)
 	: m_dataBySecond(dataBySecond)
@@ -92,12 +101,25 @@ struct HarmInstrument : Instrument
 		double value = 0.0;
 
 		for(size_t i=0; i<m_freqs.size(); i++)
-			value += m_freqs[i].mod * sin(h2f(k, m_base_freq)*(i+1)*m_time+m_freqs[i].arg + phase);
+			value += m_freqs[i].mod * sin(m_base_freq*semitone_ratio(k)*(i+1)*m_time+m_freqs[i].arg + phase);
 
 		m_time += 2*Math::Pi/m_dataBySecond;
 
 		return value;
 	}
+
+	virtual void gen_values(int k, double phase, double ampl, double* out, size_t n)
+	{
+		double f = m_base_freq*semitone_ratio(k);
+
+		m_bank.resize(m_freqs.size());
+		for(size_t i=0; i<m_freqs.size(); i++)
+			m_bank.set(i, m_freqs[i].mod, f*(i+1)*2*Math::Pi/m_dataBySecond, f*(i+1)*m_time+m_freqs[i].arg + phase);
+
+		m_bank.generate(out, n, ampl);
+
+		m_time += n*2*Math::Pi/m_dataBySecond;
+	}
 };
 
 inline ostream& operator<<(ostream& out, const HarmInstrument& instr)
@@ -162,7 +184,7 @@ struct WaveInstrument : Instrument
 
 	virtual double gen_value(int k, double phase=0.0)
 	{
-		double f = h2f(k, m_AFreq);
+		double f = fast_h2f(k, m_AFreq);
 
 		int i = int(f*(m_time+phase)*m_data.size()/(2*Math::Pi))%m_data.size();
 
@@ -178,7 +200,8 @@ struct FreqInstrument : Instrument
 {
 	static double get_freq(double lowest_freq, int i, double AFreq)
 	{
-		return h2f(int(f2h(lowest_freq, AFreq)+i), AFreq);
+		double ht = fast_f2hf(lowest_freq, AFreq);
+		return fast_h2f(int((ht>0)?ht+0.5:ht-0.5)+i, AFreq);
 	}
 
 	int m_dataBySecond;
@@ -186,6 +209,7 @@ struct FreqInstrument : Instrument
 	double m_time;
 	vector< Math::polar<double> > m_freqs;
 	double m_lowest_freq;
+	OscillatorBank m_bank;
 
 	virtual vector< Math::polar<double> >* getFreqs(){return &m_freqs;}
 
@@ -242,6 +266,20 @@ struct FreqInstrument : Instrument
 
 		return value;
 	}
+
+	virtual void gen_values(int k, double phase, double ampl, double* out, size_t n)
+	{
+		m_bank.resize(m_freqs.size());
+		for(size_t i=0; i<m_freqs.size(); i++)
+		{
+			double f = get_freq(m_lowest_freq,i+k,m_AFreq);
+			m_bank.set(i, m_freqs[i].mod, f*2*Math::Pi/m_dataBySecond, f*m_time + m_freqs[i].arg);
+		}
+
+		m_bank.generate(out, n, ampl);
+
+		m_time += n*2*Math::Pi/m_dataBySecond;
+	}
 };
 
 inline ostream& operator<<(ostream& out, const FreqInstrument& instr)
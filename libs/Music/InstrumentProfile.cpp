@@ -0,0 +1,57 @@
+// Copyright 2004 "Gilles Degottex"
+
+// This file is part of "Music"
+
+// "Music" is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 2.1 of the License, or
+// (at your option) any later version.
+// 
+// "Music" is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+
+#include "InstrumentProfile.h"
+
+namespace Music
+{
+	static vector<InstrumentProfile> BuildInstrumentProfiles()
+	{
+		int all[] = {12, 19, 24};
+		vector<int> harmonics(all, all+3);
+		// 41Hz periods: 3 multiples already need 73ms of signal
+		vector<int> bass_harmonics(all, all+2);
+
+		vector<InstrumentProfile> profiles;
+		profiles.push_back(InstrumentProfile("full", -48, 48, harmonics));
+		profiles.push_back(InstrumentProfile("guitar", -29, 19, harmonics));		// E2 to E6
+		profiles.push_back(InstrumentProfile("guitar7", -34, 19, harmonics));		// B1 to E6
+		profiles.push_back(InstrumentProfile("bass", -41, -2, bass_harmonics));		// E1 to G4
+		profiles.push_back(InstrumentProfile("voice", -29, 15, harmonics));		// E2 to C6
+
+		return profiles;
+	}
+
+	const vector<InstrumentProfile>& GetInstrumentProfiles()
+	{
+		static const vector<InstrumentProfile> s_profiles = BuildInstrumentProfiles();
+		return s_profiles;
+	}
+
+	const InstrumentProfile* FindInstrumentProfile(const string& name)
+	{
+		const vector<InstrumentProfile>& profiles = GetInstrumentProfiles();
+		for(size_t i=0; i<profiles.size(); i++)
+			if(profiles[i].name==name)
+				return &profiles[i];
+
+		return NULL;
+	}
+}
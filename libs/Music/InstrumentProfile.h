@@ -0,0 +1,58 @@
+// Copyright 2004 "Gilles Degottex"
+
+// This file is part of "Music"
+
+// "Music" is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 2.1 of the License, or
+// (at your option) any later version.
+// 
+// "Music" is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+
+#ifndef _InstrumentProfile_h_
+#define _InstrumentProfile_h_
+
+#include <string>
+#include <vector>
+using namespace std;
+
+namespace Music
+{
+	//! the notes range of an instrument, used to restrict the analysis
+	/*!
+	 * The low semi-tones cost the most to analyse (the longest periods) and
+	 * bring sub-harmonic errors, so the analysis should not go below the
+	 * lowest note of the instrument.
+	 */
+	struct InstrumentProfile
+	{
+		string name;
+		//! lowest note, in semi-tones from A3
+		int semitone_min;
+		//! highest note, in semi-tones from A3
+		int semitone_max;
+		//! periods multiples checked by the detectors, in semi-tones below the fondamental
+		vector<int> harmonics;
+
+		InstrumentProfile(const string& n, int min_ht, int max_ht, const vector<int>& h)
+			: name(n), semitone_min(min_ht), semitone_max(max_ht), harmonics(h) {}
+
+		int getNbSemitones() const						{return semitone_max-semitone_min+1;}
+	};
+
+	//! the known profiles, the first one is the whole default range
+	const vector<InstrumentProfile>& GetInstrumentProfiles();
+	//! NULL if there is no profile of that name
+	const InstrumentProfile* FindInstrumentProfile(const string& name);
+}
+
+#endif // _InstrumentProfile_h_
@@ -0,0 +1,252 @@
+// Copyright 2004 "Gilles Degottex"
+
+// This file is part of "Music"
+
+// "Music" is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 2.1 of the License, or
+// (at your option) any later version.
+// 
+// "Music" is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+
+#include "JitterBuffer.h"
+
+#include <cmath>
+#include <iostream>
+#include <algorithm>
+using namespace std;
+
+//#define MUSIC_DEBUG
+#ifdef MUSIC_DEBUG
+#define LOG(a)	a
+#else
+#define LOG(a)
+#endif
+
+namespace Music
+{
+	JitterBuffer::JitterBuffer(int depth, double max_delay)
+	: m_slots(NB_SLOTS)
+	, m_depth(depth)
+	, m_max_delay(max_delay)
+	{
+		reset();
+	}
+
+	void JitterBuffer::reset()
+	{
+		for(size_t i=0; i<m_slots.size(); i++)
+			m_slots[i].used = false;
+
+		m_started = false;
+		m_next_seq = 0;
+		m_next_timestamp = 0;
+		m_nb_buffered = 0;
+		m_highest = -1;
+		m_waiting_since = -1.0;
+
+		m_history.clear();
+		m_conceal_period = 0;
+		m_conceal_pos = 0;
+		m_conceal_gain = 1.0f;
+
+		m_ready.clear();
+	}
+
+	void JitterBuffer::insert(uint16_t seq, uint32_t timestamp, const float* samples, size_t n, double now)
+	{
+		m_stats.received++;
+
+		if(!m_started)
+		{
+			m_started = true;
+			m_next_seq = seq;
+			m_next_timestamp = timestamp;
+		}
+
+		int delta = int16_t(uint16_t(seq-m_next_seq));
+
+		if(delta<0 && delta>=-NB_SLOTS)
+		{
+			m_stats.late++;
+			return;
+		}
+
+		if(delta<0 || delta>=NB_SLOTS)
+		{
+			LOG(cerr << "JitterBuffer: resync from " << m_next_seq << " to " << seq << endl;)
+			flush(now, true, m_ready);
+			m_stats.resyncs++;
+			m_next_seq = seq;
+			m_next_timestamp = timestamp;
+			m_highest = -1;
+			delta = 0;
+		}
+
+		Slot& slot = m_slots[seq%NB_SLOTS];
+		if(slot.used)
+		{
+			m_stats.duplicated++;
+			return;
+		}
+
+		if(delta<m_highest)
+			m_stats.reordered++;
+
+		slot.used = true;
+		slot.seq = seq;
+		slot.timestamp = timestamp;
+		slot.samples.assign(samples, samples+n);
+		m_nb_buffered++;
+		m_highest = max(m_highest, delta);
+
+		if(delta>0 && m_waiting_since<0.0)
+			m_waiting_since = now;
+	}
+
+	void JitterBuffer::release(Slot& slot, vector<float>& out)
+	{
+		out.insert(out.end(), slot.samples.begin(), slot.samples.end());
+
+		m_history.insert(m_history.end(), slot.samples.begin(), slot.samples.end());
+		if(m_history.size()>HISTORY_SIZE)
+			m_history.erase(m_history.begin(), m_history.end()-HISTORY_SIZE);
+		m_conceal_period = 0;
+
+		m_next_seq++;
+		m_next_timestamp = slot.timestamp+uint32_t(slot.samples.size());
+		slot.used = false;
+		m_nb_buffered--;
+		m_highest--;
+	}
+
+	size_t JitterBuffer::getPeriod() const
+	{
+		size_t h = m_history.size();
+		size_t w = h/2;
+		if(w<2*MIN_PERIOD)
+			return h;
+
+		const float* x = &m_history[h-w];
+		double e0 = 0.0;
+		for(size_t i=0; i<w; i++)
+			e0 += x[i]*x[i];
+
+		size_t best_period = w;
+		double best = -1.0;
+		for(size_t p=MIN_PERIOD; p<=w; p++)
+		{
+			double c = 0.0;
+			double e = 0.0;
+			for(size_t i=0; i<w; i++)
+			{
+				c += x[i]*x[int(i)-int(p)];
+				e += x[int(i)-int(p)]*x[int(i)-int(p)];
+			}
+			double r = c/sqrt(e0*e+1e-20);
+			if(r>best)
+			{
+				best = r;
+				best_period = p;
+			}
+		}
+
+		return best_period;
+	}
+
+	void JitterBuffer::conceal(size_t n, vector<float>& out)
+	{
+		m_stats.concealed += n;
+
+		if(m_history.empty())
+		{
+			out.insert(out.end(), n, 0.0f);
+			return;
+		}
+
+		if(m_conceal_period==0)
+		{
+			m_conceal_period = getPeriod();
+			m_conceal_pos = 0;
+			m_conceal_gain = 1.0f;
+		}
+
+		// the last period over and over, fading out along the history length
+		const float* period = &m_history[m_history.size()-m_conceal_period];
+		float fade = 1.0f/HISTORY_SIZE;
+		for(size_t i=0; i<n; i++)
+		{
+			out.push_back(m_conceal_gain*period[m_conceal_pos]);
+			m_conceal_pos = (m_conceal_pos+1)%m_conceal_period;
+			m_conceal_gain = max(0.0f, m_conceal_gain-fade);
+		}
+	}
+
+	void JitterBuffer::flush(double now, bool force, vector<float>& out)
+	{
+		while(m_nb_buffered>0)
+		{
+			Slot& head = m_slots[m_next_seq%NB_SLOTS];
+			if(head.used && head.seq==m_next_seq)
+			{
+				release(head, out);
+				m_waiting_since = (m_nb_buffered>0)?now:-1.0;
+				continue;
+			}
+
+			// the head is missing, wait for it a little
+			if(!force && m_highest<m_depth && (m_waiting_since<0.0 || now-m_waiting_since<m_max_delay))
+				break;
+
+			// lost, up to the next received packet
+			int d = 1;
+			while(!(m_slots[uint16_t(m_next_seq+d)%NB_SLOTS].used && m_slots[uint16_t(m_next_seq+d)%NB_SLOTS].seq==uint16_t(m_next_seq+d)))
+				d++;
+			const Slot& next = m_slots[uint16_t(m_next_seq+d)%NB_SLOTS];
+
+			// the time stamps give the lost duration, unless they are inconsistent
+			int32_t gap = int32_t(next.timestamp-m_next_timestamp);
+			if(gap<0 || gap>int32_t(d*max(next.samples.size(), size_t(1))*4))
+				gap = int32_t(d*next.samples.size());
+
+			LOG(cerr << "JitterBuffer: lost " << d << " packets from " << m_next_seq << " (" << gap << " samples)" << endl;)
+
+			conceal(gap, out);
+			m_stats.lost += d;
+			m_next_seq += d;
+			m_next_timestamp = next.timestamp;
+			m_highest -= d;
+		}
+
+		if(m_nb_buffered==0)
+			m_waiting_since = -1.0;
+	}
+
+	void JitterBuffer::pull(vector<float>& out, double now)
+	{
+		if(!m_ready.empty())
+		{
+			out.insert(out.end(), m_ready.begin(), m_ready.end());
+			m_ready.clear();
+		}
+
+		flush(now, false, out);
+	}
+
+	double JitterBuffer::getTimeout(double now) const
+	{
+		if(m_nb_buffered==0 || m_waiting_since<0.0)
+			return -1.0;
+
+		return max(0.0, m_waiting_since+m_max_delay-now);
+	}
+}
@@ -0,0 +1,128 @@
+// Copyright 2004 "Gilles Degottex"
+
+// This file is part of "Music"
+
+// "Music" is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 2.1 of the License, or
+// (at your option) any later version.
+// 
+// "Music" is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+
+#ifndef _JitterBuffer_h_
+#define _JitterBuffer_h_
+
+#include <stdint.h>
+#include <vector>
+using namespace std;
+
+namespace Music
+{
+	//! reorder the packets of an audio stream, detect the gaps and conceal the lost packets
+	/*!
+	 * The packets are numbered (16 bits sequence numbers, wrapping) and stamped
+	 * with the position of their first sample (32 bits, wrapping), as RTP does.
+	 * A packet is released as soon as all the previous ones are. A missing
+	 * packet is declared lost when \ref setDepth packets after it have arrived,
+	 * or when the following packets have waited for \ref setMaxDelay.
+	 * The lost samples, counted with the time stamps, are concealed by
+	 * repeating the last period of the signal (the lag of the best
+	 * autocorrelation of the last samples) with a fade out, so the pitch goes
+	 * on through short losses; long losses become silence.
+	 * A jump of more than the buffer size in the sequence numbers (restart of
+	 * the sender) resynchronises the buffer on the new packet.
+	 */
+	class JitterBuffer
+	{
+	  public:
+		struct Stats
+		{
+			long received;
+			long lost;				// packets
+			long concealed;			// samples
+			long late;				// arrived after being declared lost
+			long duplicated;
+			long reordered;
+			long resyncs;
+			Stats() : received(0), lost(0), concealed(0), late(0), duplicated(0), reordered(0), resyncs(0) {}
+		};
+
+	  private:
+		struct Slot
+		{
+			bool used;
+			uint16_t seq;
+			uint32_t timestamp;
+			vector<float> samples;
+			Slot() : used(false), seq(0), timestamp(0) {}
+		};
+		enum {NB_SLOTS=64};
+		vector<Slot> m_slots;
+
+		int m_depth;
+		double m_max_delay;
+
+		bool m_started;
+		uint16_t m_next_seq;		// the next packet to release
+		uint32_t m_next_timestamp;
+		int m_nb_buffered;
+		int m_highest;				// highest sequence number received, relative to m_next_seq
+		double m_waiting_since;		// since when packets wait for a missing one, <0 if none
+
+		enum {HISTORY_SIZE=1024, MIN_PERIOD=16};
+		vector<float> m_history;	// the last released samples, for the concealment
+		size_t m_conceal_period;	// 0 if not concealing
+		size_t m_conceal_pos;
+		float m_conceal_gain;
+		size_t getPeriod() const;
+
+		vector<float> m_ready;		// released by \ref insert on a resync
+
+		Stats m_stats;
+
+		void release(Slot& slot, vector<float>& out);
+		void conceal(size_t n, vector<float>& out);
+		//! release what can be released, forcing the losses if force
+		void flush(double now, bool force, vector<float>& out);
+
+	  public:
+		//! unique ctor
+		/*!
+		 * \param depth number of packets after a missing one before it is declared lost
+		 * \param max_delay maximal waiting time of the packets for a missing one {seconds}
+		 */
+		JitterBuffer(int depth=4, double max_delay=0.04);
+
+		void setDepth(int depth)				{m_depth=depth;}
+		int getDepth() const					{return m_depth;}
+		void setMaxDelay(double max_delay)		{m_max_delay=max_delay;}
+		double getMaxDelay() const				{return m_max_delay;}
+
+		//! forget the packets and the stream position, keep the stats
+		void reset();
+
+		//! add a packet
+		/*!
+		 * \param now arrival time {seconds}
+		 */
+		void insert(uint16_t seq, uint32_t timestamp, const float* samples, size_t n, double now);
+		//! append to out the samples which can be released in order, with the concealed ones
+		void pull(vector<float>& out, double now);
+		//! time until a missing packet is declared lost, <0 if nothing waits {seconds}
+		double getTimeout(double now) const;
+
+		const Stats& getStats() const			{return m_stats;}
+		void resetStats()						{m_stats=Stats();}
+	};
+}
+
+#endif // _JitterBuffer_h_
@@ -23,6 +23,7 @@
 #include <cmath>
 #include <iostream>
 #include <limits>
+#include <algorithm>
 using namespace std;
 #include <CppAddons/Math.h>
 using namespace Math;
@@ -40,11 +41,19 @@ namespace Music
 {
 	void MultiCorrelationAlgo::init()
 	{
-		for(size_t i=0; i<size(); i++)
+		double latency_factor = m_latency_factor;
+		m_bank.build(
+			[latency_factor](int ht){return new Correlation(latency_factor, ht);},
+			[](const Correlation&){return true;});	// the latency factor is changed in place
+	}
+	void MultiCorrelationAlgo::adopt()
+	{
+		if(m_bank.adopt(m_corrs))
 		{
-			if(m_corrs[i]!=NULL)	delete m_corrs[i];
-
-			m_corrs[i] = new Correlation(m_latency_factor, i+GetSemitoneMin());
+			m_components.resize(m_corrs.size());
+			m_is_fondamental.resize(m_corrs.size());
+			m_first_fond = -1;
+			m_confidence = 0.0;
 		}
 	}
 
@@ -54,14 +63,19 @@ namespace Music
 	{
 		assert(GetSamplingRate()>0);
 
-		m_max_harm = 3;
+		int harmonics[] = {12, 19, 24};
+		setHarmonics(vector<int>(harmonics, harmonics+3));
+		m_max_verified = 4;
+		m_tracking_treshold = 0.5;
+		m_tracking = false;
+		m_tracking_window = 2;
+		m_tracking_confidence = 0.7;
+		m_confidence = 0.0;
 
 		m_test_complexity = test_complexity;
 
-		m_corrs.resize(size());
-		for(size_t i=0; i<size(); i++)
-			m_corrs[i] = NULL;
 		init();
+		adopt();
 	}
 	void MultiCorrelationAlgo::setLatencyFactor(double latency_factor)
 	{
@@ -69,8 +83,17 @@ namespace Music
 		for(size_t i=0; i<size(); i++)
 			m_corrs[i]->m_latency_factor = latency_factor;
 	}
+	void MultiCorrelationAlgo::setHarmonics(const vector<int>& harmonics)
+	{
+		m_harmonics = harmonics;
+		m_max_harm = int(m_harmonics.size());
+	}
 	bool MultiCorrelationAlgo::is_minima(int ih)
 	{
+		// nothing known out of the analysed range
+		if(ih<0 || ih>=int(size()))
+			return true;
+
 		if(ih+1>=0 && ih+1<int(size()))
 			if(m_components[ih+1]<=m_components[ih])
 				return false;
@@ -79,13 +102,132 @@ namespace Music
 				return false;
 		return true;
 	}
+	static bool greater_sum(const pair<double, int>& a, const pair<double, int>& b)
+	{
+		return a.first>b.first;
+	}
+	//! the candidate stays a minima on the shifted signal
+	bool MultiCorrelationAlgo::verify(const Frame& frame, int ih)
+	{
+		double err[3];
+		size_t step = size_t(m_corrs[ih]->m_s/m_test_complexity);
+		if(step<1)	step = 1;
+		// no shift is the full search itself, already a minima
+		for(size_t s=step; s<m_corrs[ih]->m_s; s+=step)
+		{
+			for(int i=0; i<3; i++)
+				if(ih-1+i>=0 && ih-1+i<int(size()))
+				{
+					m_corrs[ih-1+i]->receive(frame, s);
+					err[i] = m_corrs[ih-1+i]->m_error;
+				}
+
+			if((ih-1>=0 && err[0]<=err[1]) || (ih+1<int(size()) && err[2]<=err[1]))
+				return false;
+		}
+
+		return true;
+	}
 	int MultiCorrelationAlgo::getFondamentalWaveLength() const
 	{
-		return int(GetSamplingRate()/h2f(m_first_fond+GetSemitoneMin(), GetAFreq()));
+		return int(fast_h2wl(m_first_fond+GetSemitoneMin()));
 	}
-	void MultiCorrelationAlgo::apply(const deque<double>& buff)
+	bool MultiCorrelationAlgo::track(const Frame& frame)
+	{
+		adopt();
+
+		int ih = m_first_fond;
+		if(ih==-1 || frame.size()<(m_test_complexity+m_latency_factor+1)*m_corrs[0]->m_s)
+			return false;
+
+		bool ok = false;
+		if(m_tracking)
+		{
+			// the note may glide: search the window around it
+			ok = m_confidence>=m_tracking_confidence
+				&& frame.peak(m_corrs[0]->m_s)>getVolumeTreshold()
+				&& search_near(frame, ih);
+		}
+		else
+		{
+			// the note is still there if its error is still small (relatively to the
+			// last full apply) and clearly below its neighbours ones
+			double neighbours = numeric_limits<double>::max();
+			for(int i=max(0, ih-1); i<=ih+1 && i<int(size()); i++)
+			{
+				correlate(frame, i);
+				if(i!=ih)
+					neighbours = min(neighbours, m_components[i]);
+			}
+
+			ok = m_components[ih]/m_components_max<=getComponentsTreshold()
+				&& m_components[ih] < m_tracking_treshold*neighbours;
+		}
+
+		LOG(cerr << "MultiCorrelationAlgo::track " << ih << "->" << m_first_fond << " " << ok << endl;)
+
+		if(!ok)
+		{
+			m_is_fondamental[ih] = false;
+			m_first_fond = -1;
+			m_confidence = 0.0;
+		}
+
+		return ok;
+	}
+	bool MultiCorrelationAlgo::search_near(const Frame& frame, int prev)
+	{
+		int n = int(size());
+		double local_max = 0.0;
+
+		// the window, with one more semi-tone on each side for the minima test
+		for(int ih=max(0, prev-m_tracking_window-1); ih<=min(n-1, prev+m_tracking_window+1); ih++)
+			local_max = max(local_max, correlate(frame, ih));
+
+		int fond = -1;
+		for(int ih=max(0, prev-m_tracking_window); ih<=min(n-1, prev+m_tracking_window); ih++)
+			if(is_minima(ih) && (fond==-1 || m_components[ih]<m_components[fond]))
+				fond = ih;
+		if(fond==-1)
+			return false;
+
+		// the lower octave has to be periodic too, and the upper harmonics
+		// must not be: else fond may be a sub-harmonic
+		for(int ih=max(0, fond-12-1); ih<=min(n-1, fond-12+1); ih++)
+			local_max = max(local_max, correlate(frame, ih));
+		for(size_t h=0; h<m_harmonics.size(); h++)
+			for(int ih=max(0, fond+m_harmonics[h]-1); ih<=min(n-1, fond+m_harmonics[h]+1); ih++)
+				local_max = max(local_max, correlate(frame, ih));
+
+		m_components_max = local_max;
+		if(m_components[fond]/m_components_max>getComponentsTreshold())
+			return false;
+		if(fond-12>=0 && !is_minima(fond-12))
+			return false;
+		for(size_t h=0; h<m_harmonics.size(); h++)
+		{
+			int ih = fond+m_harmonics[h];
+			if(ih<n && is_minima(ih) && m_components[ih]/m_components_max<=getComponentsTreshold())
+				return false;
+		}
+
+		m_confidence = 1.0-m_components[fond]/m_components_max;
+		if(m_confidence<m_tracking_confidence)
+			return false;
+
+		m_is_fondamental[prev] = false;
+		m_first_fond = fond;
+		m_is_fondamental[fond] = true;
+
+		LOG(cerr << "MultiCorrelationAlgo::search_near " << prev << "->" << fond << " confidence=" << m_confidence << endl;)
+
+		return true;
+	}
+	void MultiCorrelationAlgo::apply(const Frame& frame)
 	{
 		assert(GetSamplingRate()>0);
+		adopt();
+
 		for(size_t i=0; i<size(); i++)
 		{
 			m_components[i] = 1.0;
@@ -93,27 +235,19 @@ namespace Music
 		}
 
 		m_first_fond = -1;
+		m_confidence = 0.0;
 
 //		if(buff.size()<max(double((m_max_harm+1)*m_test_complexity*m_corrs[0]->m_s), (m_latency_factor+1)*m_corrs[0]->m_s))
-		if(buff.empty() || buff.size()<(m_test_complexity+m_latency_factor+1)*m_corrs[0]->m_s)
+		if(frame.size()==0 || frame.size()<(m_test_complexity+m_latency_factor+1)*m_corrs[0]->m_s)
 			return;
 
-		double v = 0.0;
-		for(size_t i=0; i<buff.size() && v<=getVolumeTreshold() && i<m_corrs[0]->m_s; i++)
-			v = max(v, abs(buff[i]));
-
-		if(v>getVolumeTreshold())
+		if(frame.peak(m_corrs[0]->m_s)>getVolumeTreshold())
 		{
 			// compute all components
 			m_components_max = 0.0;
-			double min_comp = 1000000;
-			double max_sum = 0.0;
 			for(int ih=int(size())-1; ih>=0; ih--)
-			{
-				m_corrs[ih]->receive(buff, 0);
-				m_components[ih] = m_corrs[ih]->m_error;
-				m_components_max = max(m_components_max, m_components[ih]);
-			}
+				m_components_max = max(m_components_max, correlate(frame, ih));
+			m_candidates.clear();
 
 			// test components
 			for(int ih=int(size())-1; ih>=0; ih--)
@@ -122,11 +256,16 @@ namespace Music
 
 				bool crit_min = true;
 				// criteria: the fond and his first harmonics are minimas
-				if(ok)	ok =
-							is_minima(ih) &&
-							is_minima(ih-12) &&
-							(is_minima(ih-19) || is_minima(ih-19-1) || is_minima(ih-19+1)) &&
-							is_minima(ih-24);
+				//	(the non-octave ones are not tempered, so one semi-tone around)
+				if(ok)	ok = is_minima(ih);
+				for(size_t h=0; ok && h<m_harmonics.size(); h++)
+				{
+					int i = ih-m_harmonics[h];
+					if(m_harmonics[h]%12==0)
+						ok = is_minima(i);
+					else
+						ok = is_minima(i) || is_minima(i-1) || is_minima(i+1);
+				}
 
 				crit_min = ok;
 
@@ -204,52 +343,37 @@ namespace Music
 					int i=0;
 					double wh = 1.0;
 					sum += wh*(m_components_max-m_components[ih]); n++;
-					i=12;	if(ih-i>=0)	{sum+=wh*(m_components_max-m_components[ih-i]);	n++;}
-					i=19;	if(ih-i>=0)	{sum+=wh*(m_components_max-m_components[ih-i]);	n++;}
-					i=24;	if(ih-i>=0)	{sum+=wh*(m_components_max-m_components[ih-i]);	n++;}
+					for(size_t h=0; h<m_harmonics.size(); h++)
+					{
+						i = m_harmonics[h];
+						if(ih-i>=0)	{sum+=wh*(m_components_max-m_components[ih-i]);	n++;}
+					}
 
 					LOG(cerr << "ih=" << ih << " sum=" << sum << endl;)
 
-					// get the "best"
-					if(sum>max_sum)
-					{
-						size_t step = size_t(m_corrs[ih]->m_s/m_test_complexity);
-						if(step<1)	step = 1;
-						for(size_t s=0; ok && s<m_corrs[ih]->m_s; s+=step)
-						{
-							if(ih-1>=0){
-								m_corrs[ih-1]->receive(buff, s);
-								m_components[ih-1] = m_corrs[ih-1]->m_error;
-							}
-							if(ih+1<int(size())){
-								m_corrs[ih+1]->receive(buff, s);
-								m_components[ih+1] = m_corrs[ih+1]->m_error;
-							}
-							m_corrs[ih]->receive(buff, s);
-							m_components[ih] = m_corrs[ih]->m_error;
-							ok = is_minima(ih);
-						}
-
-						if(ok)
-						{
-							max_sum = sum;
-							min_comp = m_components[ih];
-							m_first_fond = ih;
-						}
-					}
+					if(sum>0.0)
+						m_candidates.push_back(make_pair(sum, ih));
 				}
 			}
 
+			// verify the best candidates first, the first one passing is the best one
+			// (stable: the highest semi-tone first on equal scores)
+			stable_sort(m_candidates.begin(), m_candidates.end(), greater_sum);
+			for(size_t c=0; c<m_candidates.size() && c<size_t(m_max_verified) && m_first_fond==-1; c++)
+				if(verify(frame, m_candidates[c].second))
+					m_first_fond = m_candidates[c].second;
+
 			if(m_first_fond!=-1)
+			{
 				m_is_fondamental[m_first_fond] = true;
+				m_confidence = 1.0-m_components[m_first_fond]/m_components_max;
+			}
 
 			LOG(cerr << "m_first_fond=" << m_first_fond << endl;)
 		}
 	}
 	MultiCorrelationAlgo::~MultiCorrelationAlgo()
 	{
-		for(size_t i=0; i<m_corrs.size(); i++)
-			delete m_corrs[i];
 	}
 }
 
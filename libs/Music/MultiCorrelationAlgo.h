@@ -25,6 +25,7 @@
 using namespace std;
 #include "Algorithm.h"
 #include "Correlation.h"
+#include "SemitoneBank.h"
 
 namespace Music
 {
@@ -34,15 +35,36 @@ namespace Music
 		double m_latency_factor;
 		double m_test_complexity;
 		int m_max_harm;
+		vector<int> m_harmonics;
+		double m_tracking_treshold;
+
+		bool m_tracking;
+		int m_tracking_window;
+		double m_tracking_confidence;
+		double m_confidence;
+
+		int m_max_verified;
+
+		SemitoneBank<Correlation> m_bank;
+		void adopt();
+
+		double correlate(const Frame& frame, int ih)		{m_corrs[ih]->receive(frame); return m_components[ih] = m_corrs[ih]->m_error;}
+
+		//! candidates passing the criteria, with their harmonic score
+		vector< pair<double, int> > m_candidates;
+		bool verify(const Frame& frame, int ih);
+
+		bool search_near(const Frame& frame, int prev);
 
 	  protected:
+		//! rebuild the correlations, they are used from the next \ref apply
 		void init();
 		virtual void AFreqChanged()							{init();}
 		virtual void samplingRateChanged()					{init();}
 		virtual void semitoneBoundsChanged()				{init();}
 
 	  public:
-		//! correlation filters
+		//! correlation filters (owned by m_bank)
 		vector< Correlation* > m_corrs;
 
 		bool is_minima(int ih);
@@ -54,6 +76,35 @@ namespace Music
 		double getLatencyFactor()							{return m_latency_factor;}
 		void setTestComplexity(double test_complexity)		{m_test_complexity = test_complexity;}
 		double getTestComplexity()							{return m_test_complexity;}
+		//! the periods multiples checked for each candidate, in semi-tones below it (12, 19, 24)
+		void setHarmonics(const vector<int>& harmonics);
+		const vector<int>& getHarmonics()					{return m_harmonics;}
+		//! only the best candidates are verified on shifted signal [1;oo[
+		void setMaxVerifiedCandidates(int n)				{m_max_verified = n;}
+		int getMaxVerifiedCandidates()						{return m_max_verified;}
+		//! maximal error ratio between the tracked semi-tone and its neighbours ]0;1]
+		void setTrackingTreshold(double t)					{m_tracking_treshold = t;}
+		double getTrackingTreshold()						{return m_tracking_treshold;}
+
+		//! let \ref track search near the previous note while it is confidently recognized
+		/*!
+		 * Only the semi-tones of the window around the previous note and the
+		 * octaves of the result are correlated, without the harmonics tests.
+		 * Otherwise \ref track only checks the previous note against its two
+		 * neighbours. \ref apply always does the full search: the caller
+		 * goes back to it on the \ref track failures, on the onsets, and
+		 * regularly against the octave errors.
+		 */
+		void setTracking(bool tracking)						{m_tracking = tracking;}
+		bool isTracking()									{return m_tracking;}
+		//! searched semi-tones on each side of the previous note [0;12[
+		void setTrackingWindow(int w)						{m_tracking_window = w;}
+		int getTrackingWindow()								{return m_tracking_window;}
+		//! minimal confidence for the tracking to go on [0;1]
+		void setTrackingConfidence(double c)				{m_tracking_confidence = c;}
+		double getTrackingConfidence()						{return m_tracking_confidence;}
+		//! 1-(error of the fondamental)/(maximal error), 0 if no note
+		virtual double getConfidence() const				{return m_confidence;}
 
 		virtual int getSampleAlgoLatency() const			{return int((getAlgoLatency()/1000.0)*GetSamplingRate());}
 		//! in millis
@@ -73,7 +124,10 @@ namespace Music
 		MultiCorrelationAlgo(int latency_factor, double test_complexity);
 
 		//! overwrited compute fonction
-		virtual void apply(const deque<double>& buff);
+		virtual void apply(const Frame& frame);
+		//! only the recognized semi-tone and its neighbours are correlated, see \ref setTracking
+		virtual bool track(const Frame& frame);
+		virtual void notifyOnset()							{m_confidence = 0.0;}
 		
 		virtual int getFondamentalWaveLength() const;
 
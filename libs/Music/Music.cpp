@@ -21,6 +21,9 @@
 
 #include <algorithm>
 #include <iostream>
+#include <map>
+#include <mutex>
+#include <chrono>
 using namespace std;
 
 Music::NotesName Music::s_notes_name = Music::LOCAL_ANGLO;
@@ -31,6 +34,53 @@ const int Music::UNDEFINED_SEMITONE = -1000;
 int Music::s_semitone_min = -48;
 int Music::s_semitone_max = +48;
 
+Music::StaticTables::StaticTables()
+{
+	for(int i=0; i<TABLE_SIZE; i++)
+		ratio[i] = pow(2.0, (TABLE_HT_MIN+double(i)/TABLE_SUBDIV)/12.0);
+	for(int i=0; i<=TABLE_LOG2_SIZE; i++)
+		log2[i] = log(1.0+double(i)/TABLE_LOG2_SIZE)/log(2.0);
+}
+
+atomic<const Music::SettingsTables*> Music::s_settings_tables(NULL);
+
+// a reader only holds the tables during one lookup, the replaced ones are
+// freed once they have been retired for more than the grace period
+static const double TABLES_GRACE_PERIOD = 1.0;	// seconds
+static mutex s_tables_mutex;
+static list< pair<const Music::SettingsTables*, chrono::steady_clock::time_point> > s_retired_tables;
+
+void Music::BuildTables()
+{
+	lock_guard<mutex> lock(s_tables_mutex);
+
+	const SettingsTables* current = s_settings_tables.load(memory_order_relaxed);
+	if(current!=NULL && current->sampling_rate==s_sampling_rate && current->AFreq==s_AFreq)
+		return;
+
+	SettingsTables* tables = new SettingsTables();
+	tables->sampling_rate = s_sampling_rate;
+	tables->AFreq = s_AFreq;
+
+	// no wave length without sampling rate
+	double sr = (s_sampling_rate>0)?s_sampling_rate:1.0;
+	const double* ratio = GetStaticTables().ratio;
+	for(int i=0; i<TABLE_SIZE; i++)
+		tables->wave_length[i] = sr/(s_AFreq*ratio[i]);
+	tables->wl2hf_offset = 12.0*(log(sr)-log(s_AFreq))/log(2.0);
+
+	s_settings_tables.store(tables, memory_order_release);
+
+	chrono::steady_clock::time_point now = chrono::steady_clock::now();
+	while(!s_retired_tables.empty() && chrono::duration<double>(now-s_retired_tables.front().second).count()>TABLES_GRACE_PERIOD)
+	{
+		delete s_retired_tables.front().first;
+		s_retired_tables.pop_front();
+	}
+	if(current!=NULL)
+		s_retired_tables.push_back(make_pair(current, now));
+}
+
 Music::SettingsListener::SettingsListener()
 {
 	s_settings_listeners.push_back(this);
@@ -54,6 +104,7 @@ void Music::RemoveSettingsListener(SettingsListener* l)
 void Music::SetSamplingRate(int sampling_rate)
 {
 	s_sampling_rate = sampling_rate;
+	BuildTables();
 	for(list<Music::SettingsListener*>::iterator it=s_settings_listeners.begin(); it!=s_settings_listeners.end(); ++it)
 		(*it)->samplingRateChanged();
 }
@@ -61,6 +112,7 @@ void Music::SetSamplingRate(int sampling_rate)
 void Music::SetAFreq(double AFreq)
 {
 	s_AFreq = AFreq;
+	BuildTables();
 	for(list<Music::SettingsListener*>::iterator it=s_settings_listeners.begin(); it!=s_settings_listeners.end(); ++it)
 		(*it)->AFreqChanged();
 }
@@ -74,3 +126,24 @@ void Music::SetSemitoneBounds(int semitone_min, int semitone_max)
 		(*it)->semitoneBoundsChanged();
 }
 
+// the windows normalisation cache, a few (type, factor) pairs at most
+static mutex s_windows_mutex;
+static map< pair<int, double>, double > s_windows_usefull;
+
+static double ComputeWindowUsefull(Music::WindowType type, double factor)
+{
+	if(type==Music::WINDOW_GAUSS)	return Music::Usefull(Music::Win_Gauss(factor));
+	return Music::Usefull(Music::Win_Sinc(factor));
+}
+
+double Music::GetWindowUsefull(WindowType type, double factor)
+{
+	lock_guard<mutex> lock(s_windows_mutex);
+
+	pair<int, double> key(type, factor);
+	map< pair<int, double>, double >::iterator it = s_windows_usefull.find(key);
+	if(it==s_windows_usefull.end())
+		it = s_windows_usefull.insert(make_pair(key, ComputeWindowUsefull(type, factor))).first;
+
+	return it->second;
+}
@@ -23,6 +23,8 @@
 #include <math.h>
 #include <string>
 #include <list>
+#include <vector>
+#include <atomic>
 using namespace std;
 #include <CppAddons/Math.h>
 #include <CppAddons/StringAddons.h>
@@ -99,6 +101,91 @@ inline int f2h(double freq, double AFreq=GetAFreq())
  */
 inline double h2f(double ht, double AFreq=GetAFreq())			{return AFreq * pow(2.0, ht/12.0);}
 
+//! precomputed conversion tables for the hot paths
+/*!
+ * The fractional values are linearly interpolated between the entries
+ * (relative error < 2e-6), the integer semi-tones fall exactly on entries
+ * and give the same values as \ref h2f.
+ * Out of [TABLE_HT_MIN;TABLE_HT_MAX] the exact functions are used, as well
+ * as before the first \ref BuildTables for the tables depending on the settings.
+ */
+enum {TABLE_HT_MIN=-128, TABLE_HT_MAX=128, TABLE_SUBDIV=16, TABLE_SIZE=(TABLE_HT_MAX-TABLE_HT_MIN)*TABLE_SUBDIV+1};
+enum {TABLE_LOG2_SIZE=1024};
+//! the tables not depending on the settings
+struct StaticTables
+{
+	//! 2^(ht/12) by step of 1/TABLE_SUBDIV half-tone from TABLE_HT_MIN
+	double ratio[TABLE_SIZE];
+	//! log2(1+i/TABLE_LOG2_SIZE)
+	double log2[TABLE_LOG2_SIZE+1];
+
+	StaticTables();
+};
+//! built on the first use, whatever the initialisation order of the callers
+inline const StaticTables& GetStaticTables()						{static const StaticTables s_tables; return s_tables;}
+//! the tables depending on the settings, never modified once published
+struct SettingsTables
+{
+	int sampling_rate;
+	double AFreq;
+	//! wave length in samples, same index as \ref StaticTables::ratio
+	double wave_length[TABLE_SIZE];
+	//! 12*log2(GetSamplingRate()/GetAFreq())
+	double wl2hf_offset;
+};
+//! NULL until the first \ref BuildTables
+extern atomic<const SettingsTables*> s_settings_tables;
+//! build the tables depending on the settings
+/*!
+ * The tables of new settings are built aside and published by a pointer swap,
+ * the analysis thread keeps reading consistent tables while the settings change.
+ * Called by \ref SetSamplingRate and \ref SetAFreq, before notifying the listeners.
+ */
+void BuildTables();
+
+//! linear interpolation in a semi-tone indexed table, false if out of range
+inline bool table_lookup(const double* table, double ht, double& value)
+{
+	double x = (ht-TABLE_HT_MIN)*TABLE_SUBDIV;
+	if(!(x>=0.0 && x<TABLE_SIZE-1))	return false;
+	int i = int(x);
+	value = table[i] + (x-i)*(table[i+1]-table[i]);
+	return true;
+}
+//! 2^(ht/12) without pow
+inline double semitone_ratio(double ht)
+{
+	double r;
+	return table_lookup(GetStaticTables().ratio, ht, r) ? r : pow(2.0, ht/12.0);
+}
+//! \ref h2f without pow
+inline double fast_h2f(double ht, double AFreq=GetAFreq())		{return AFreq * semitone_ratio(ht);}
+//! wave length {samples} of a semi-tone, without pow nor division
+inline double fast_h2wl(double ht)
+{
+	const SettingsTables* tables = s_settings_tables.load(memory_order_acquire);
+	double wl;
+	return (tables!=NULL && table_lookup(tables->wave_length, ht, wl)) ? wl : GetSamplingRate()/h2f(ht);
+}
+//! log2 without log (absolute error < 2e-7)
+inline double fast_log2(double x)
+{
+	if(!(x>0.0))	return log(x)/log(2.0);
+	int e;
+	double y = (2.0*frexp(x, &e)-1.0)*TABLE_LOG2_SIZE;		// frexp in [0.5;1[
+	int i = int(y);
+	const double* table = GetStaticTables().log2;
+	return e-1 + table[i] + (y-i)*(table[i+1]-table[i]);
+}
+//! \ref f2hf without log
+inline double fast_f2hf(double freq, double AFreq=GetAFreq())	{return 12.0*(fast_log2(freq)-fast_log2(AFreq));}
+//! float number of half-tones from A3 of a wave length {samples}, without log
+inline double fast_wl2hf(double wave_length)
+{
+	const SettingsTables* tables = s_settings_tables.load(memory_order_acquire);
+	return (tables!=NULL) ? tables->wl2hf_offset - 12.0*fast_log2(wave_length) : f2hf(GetSamplingRate()/wave_length);
+}
+
 //! convert half-tones from A3 to the corresponding note name
 /*!
  * \param ht number of half-tones to convert to \f$\in Z\f$
@@ -236,6 +323,15 @@ struct Win_Sinc
 	double operator()(double x)		{return win_sinc(x, m_f);}
 };
 
+enum WindowType{WINDOW_GAUSS, WINDOW_SINC};
+
+//! cached \ref Usefull of a window fonction (Simpson integration done once)
+/*!
+ * The window itself is cheap to sample, the callers do it for their own length.
+ * Thread safe.
+ */
+double GetWindowUsefull(WindowType type, double factor);
+
 //! convert cartesian coordinates to polar coordinates
 inline pair<double, double> cart2pol(double x, double y)
 {
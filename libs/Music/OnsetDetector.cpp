@@ -0,0 +1,55 @@
+// Copyright 2004 "Gilles Degottex"
+
+// This file is part of "Music"
+
+// "Music" is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 2.1 of the License, or
+// (at your option) any later version.
+// 
+// "Music" is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+#include "OnsetDetector.h"
+
+#include <algorithm>
+using namespace std;
+
+namespace Music
+{
+	OnsetDetector::OnsetDetector(double silence_threshold, double onset_ratio)
+	: m_silence_threshold(silence_threshold)
+	, m_onset_ratio(onset_ratio)
+	, m_energy(0.0)
+	, m_state(SILENCE)
+	{
+	}
+
+	OnsetDetector::State OnsetDetector::process(const Frame& frame, size_t nb_new)
+	{
+		nb_new = min(nb_new, frame.size());
+		if(nb_new==0)	return m_state;
+
+		double rms = frame.rms(nb_new);
+		double energy = rms*rms;
+
+		double previous = m_energy;
+		m_energy = energy;
+
+		if(energy < m_silence_threshold*m_silence_threshold)
+			m_state = SILENCE;
+		else if(m_state==SILENCE || energy > m_onset_ratio*previous)
+			m_state = ONSET;
+		else
+			m_state = SUSTAIN;
+
+		return m_state;
+	}
+}
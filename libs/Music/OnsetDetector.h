@@ -0,0 +1,71 @@
+// Copyright 2004 "Gilles Degottex"
+
+// This file is part of "Music"
+
+// "Music" is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 2.1 of the License, or
+// (at your option) any later version.
+// 
+// "Music" is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+#ifndef _OnsetDetector_h_
+#define _OnsetDetector_h_
+
+#include "Frame.h"
+
+namespace Music
+{
+	//! cheap front-end deciding how much analysis each hop needs
+	/*!
+	 * Computed once by hop on the new samples only: their mean energy and its
+	 * slope relatively to the previous hop.
+	 * - SILENCE: the energy is below the silence threshold, nothing to analyse
+	 * - ONSET: the energy rose by more than the onset ratio (or after a silence),
+	 *   the full detection has to run
+	 * - SUSTAIN: a note may be sustaining, checking the previous pitch is enough
+	 *   (see \ref Algorithm::track)
+	 */
+	class OnsetDetector
+	{
+	  public:
+		enum State{SILENCE, ONSET, SUSTAIN};
+
+	  private:
+		double m_silence_threshold;
+		double m_onset_ratio;
+
+		double m_energy;
+		State m_state;
+
+	  public:
+		//! unique ctor
+		/*!
+		 * \param silence_threshold RMS under which the hop is silent [0;1]
+		 * \param onset_ratio energy ratio between two hops triggering an onset ]1;oo[
+		 */
+		OnsetDetector(double silence_threshold=0.001, double onset_ratio=2.0);
+
+		double getSilenceThreshold() const				{return m_silence_threshold;}
+		void setSilenceThreshold(double t)				{m_silence_threshold=t;}
+		double getOnsetRatio() const					{return m_onset_ratio;}
+		void setOnsetRatio(double r)					{m_onset_ratio=r;}
+
+		//! classify the hop made of the nb_new most recent samples of the frame
+		State process(const Frame& frame, size_t nb_new);
+
+		State getState() const							{return m_state;}
+		//! mean energy of the last hop
+		double getEnergy() const						{return m_energy;}
+	};
+}
+
+#endif // _OnsetDetector_h_
@@ -0,0 +1,112 @@
+// Copyright 2004 "Gilles Degottex"
+
+// This file is part of "Music"
+
+// "Music" is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 2.1 of the License, or
+// (at your option) any later version.
+//
+// "Music" is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+#ifndef _Oscillator_h_
+#define _Oscillator_h_
+
+#include <math.h>
+#include <CppAddons/Simd.h>
+
+namespace Music
+{
+
+//! a bank of sinusoidal oscillators summed together
+/*!
+ * Each oscillator is a complex phasor z rotated by w=exp(i*omega) at each
+ * sample, its output is ampl*Im(z): only 4 mul and 2 add by sample, without
+ * any sin. The oscillators are processed 2 by 2 with \ref Simd::v2d.
+ * The phasors are renormalised after each block against the drift of |z|.
+ */
+class OscillatorBank
+{
+	size_t m_size;
+	Simd::vector_d m_re;
+	Simd::vector_d m_im;
+	Simd::vector_d m_wre;
+	Simd::vector_d m_wim;
+	Simd::vector_d m_ampl;
+
+  public:
+	OscillatorBank(size_t size=0)											{resize(size);}
+
+	//! set the number of oscillators, all silent
+	void resize(size_t size)
+	{
+		m_size = size;
+		size_t n = Simd::padded(size, Simd::V2D_SIZE);
+		m_re.assign(n, 1.0);
+		m_im.assign(n, 0.0);
+		m_wre.assign(n, 1.0);
+		m_wim.assign(n, 0.0);
+		m_ampl.assign(n, 0.0);
+	}
+	size_t size() const														{return m_size;}
+
+	//! ampl*sin(omega*t+phase) from t=0
+	/*!
+	 * \param omega pulsation {radians by sample}
+	 */
+	void set(size_t i, double ampl, double omega, double phase)
+	{
+		m_ampl[i] = ampl;
+		m_re[i] = cos(phase);
+		m_im[i] = sin(phase);
+		m_wre[i] = cos(omega);
+		m_wim[i] = sin(omega);
+	}
+
+	//! add ampl times the next n values of the bank to out
+	void generate(double* out, size_t n, double ampl=1.0)
+	{
+		using namespace Simd;
+
+		size_t nv = m_re.size()/V2D_SIZE;
+		v2d* re = (v2d*)&m_re[0];
+		v2d* im = (v2d*)&m_im[0];
+		const v2d* wre = (const v2d*)&m_wre[0];
+		const v2d* wim = (const v2d*)&m_wim[0];
+		const v2d* a = (const v2d*)&m_ampl[0];
+
+		for(size_t j=0; j<n; j++)
+		{
+			v2d acc = splat(0.0);
+			for(size_t v=0; v<nv; v++)
+			{
+				acc += a[v]*im[v];
+				v2d r = re[v]*wre[v] - im[v]*wim[v];
+				im[v] = re[v]*wim[v] + im[v]*wre[v];
+				re[v] = r;
+			}
+			out[j] += ampl*sum(acc);
+		}
+
+		for(size_t v=0; v<nv; v++)
+		{
+			v2d norm = re[v]*re[v] + im[v]*im[v];
+			for(int l=0; l<V2D_SIZE; l++)
+				norm[l] = 1.0/sqrt(norm[l]);
+			re[v] *= norm;
+			im[v] *= norm;
+		}
+	}
+};
+
+}
+
+#endif // _Oscillator_h_
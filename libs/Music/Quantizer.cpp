@@ -27,8 +27,7 @@ using namespace Music;
 
 Quantizer::Quantizer(float tolerance, float min_density)
 {
-	m_min_ht = -48;
-	m_channels.resize(97);
+	setSemitoneBounds(-48, 48);
 
 	m_tolerance = tolerance;
 	m_min_density = min_density;
@@ -36,6 +35,24 @@ Quantizer::Quantizer(float tolerance, float min_density)
 	m_time.start();
 }
 
+void Quantizer::setSemitoneBounds(int min_ht, int max_ht)
+{
+	// the listeners see the end of the notes lost with their channel
+	for(size_t rht=0; rht<m_channels.size(); rht++)
+	{
+		Channel& channel = m_channels[rht];
+		if(channel.state==Channel::QC_PLAYING)
+		{
+			MFireEvent(noteFinished(channel.last_tag, rht+m_min_ht, 0.0));
+			MFireEvent(notePlayed(rht+m_min_ht, channel.duration.elapsed(), -channel.duration.elapsed()));
+		}
+	}
+
+	m_min_ht = min_ht;
+	m_channels.clear();
+	m_channels.resize(max_ht-min_ht+1);
+}
+
 void Quantizer::quantize(const vector<bool> hts, int min_ht)
 {
 	double current_time = m_time.elapsed();
@@ -44,6 +61,8 @@ void Quantizer::quantize(const vector<bool> hts, int min_ht)
 	for(size_t ht=0; ht<hts.size(); ht++)
 	{
 		int rht = ht+min_ht-m_min_ht;
+		if(rht<0 || rht>=int(m_channels.size()))
+			continue;
 
 		// add the new one
 		m_channels[rht].old_states.push_front(State(current_time, hts[ht]));
@@ -74,6 +74,9 @@ class Quantizer : public Talker<QuantizerListener>
 	double getMinDensity()							{return m_min_density;}
 	void setMinDensity(float min_density)			{m_min_density=min_density;}
 
+	//! one channel by semi-tone of [min_ht;max_ht], the current notes are finished
+	void setSemitoneBounds(int min_ht, int max_ht);
+
 	void quantize(const vector<bool> hts, int min_ht);
 	void update(int ht);
 
@@ -0,0 +1,185 @@
+// Copyright 2004 "Gilles Degottex"
+
+// This file is part of "Music"
+
+// "Music" is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 2.1 of the License, or
+// (at your option) any later version.
+// 
+// "Music" is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+
+#include "Resampler.h"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+using namespace std;
+
+namespace Music
+{
+	static int greatest_common_divisor(int a, int b)
+	{
+		while(b!=0)
+		{
+			int r = a%b;
+			a = b;
+			b = r;
+		}
+		return a;
+	}
+
+	//! zeroth order modified Bessel function of the first kind
+	static double bessel_i0(double x)
+	{
+		double sum = 1.0;
+		double term = 1.0;
+		for(int k=1; k<50 && term>1e-12*sum; k++)
+		{
+			term *= (x*x/4.0)/(k*k);
+			sum += term;
+		}
+		return sum;
+	}
+
+	Resampler::Resampler(int in_rate, int out_rate, int zeros)
+	: m_in_rate(0)
+	, m_out_rate(0)
+	, m_zeros(zeros)
+	, m_L(1)
+	, m_M(1)
+	, m_nb_phases(1)
+	, m_nb_taps(0)
+	, m_size(0)
+	, m_pos(0)
+	, m_frac(0)
+	{
+		if(in_rate>0 && out_rate>0)
+			setup(in_rate, out_rate, zeros);
+	}
+
+	void Resampler::setup(int in_rate, int out_rate, int zeros)
+	{
+		m_in_rate = in_rate;
+		m_out_rate = out_rate;
+		m_zeros = zeros;
+
+		int g = greatest_common_divisor(in_rate, out_rate);
+		m_L = out_rate/g;
+		m_M = in_rate/g;
+		m_nb_phases = min(int(m_L), int(MAX_PHASES));
+
+		if(isIdentity())
+		{
+			m_nb_taps = 0;
+			m_coefs.clear();
+			m_buffer.clear();
+			reset();
+			return;
+		}
+
+		// cutoff {cycles by input sample}, below the lowest Nyquist frequency
+		double fc = 0.5*0.9*min(1.0, double(out_rate)/in_rate);
+		double half = ceil(m_zeros/(2.0*fc));
+		m_nb_taps = Simd::padded(size_t(2*half), 2*Simd::V4F_SIZE);
+
+		double beta = 8.0;
+		double norm = bessel_i0(beta);
+		m_coefs.assign(m_nb_phases*m_nb_taps, 0.0f);
+		for(int p=0; p<m_nb_phases; p++)
+		{
+			float* h = &m_coefs[p*m_nb_taps];
+			double sum = 0.0;
+			for(int j=0; j<m_nb_taps; j++)
+			{
+				// time from the tap to the output {input samples}
+				double u = double(p)/m_nb_phases + m_nb_taps/2 - 1 - j;
+				if(fabs(u)>=half)	continue;
+
+				double x = 2.0*fc*u;
+				double sinc = (x==0.0)?1.0:sin(M_PI*x)/(M_PI*x);
+				double r = u/half;
+				double w = bessel_i0(beta*sqrt(1.0-r*r))/norm;
+				h[j] = 2.0*fc*sinc*w;
+				sum += h[j];
+			}
+			// unity gain at DC for every phase
+			for(int j=0; j<m_nb_taps; j++)
+				h[j] /= sum;
+		}
+
+		m_buffer.assign(Simd::padded(4096+m_nb_taps, Simd::V4F_SIZE), 0.0f);
+		reset();
+	}
+
+	void Resampler::reset()
+	{
+		// the first output is aligned on the first input
+		m_size = (m_nb_taps>0)?m_nb_taps/2-1:0;
+		fill(m_buffer.begin(), m_buffer.end(), 0.0f);
+		m_pos = 0;
+		m_frac = 0;
+	}
+
+	void Resampler::compact()
+	{
+		size_t moved = min(m_pos, m_size);
+		memmove(&m_buffer[0], &m_buffer[moved], (m_size-moved)*sizeof(float));
+		m_size -= moved;
+		m_pos -= moved;
+	}
+
+	inline double Resampler::dot(const float* x, const float* h) const
+	{
+		using namespace Simd;
+
+		v4f acc0 = splat(0.0f);
+		v4f acc1 = splat(0.0f);
+		for(int j=0; j<m_nb_taps; j+=2*V4F_SIZE)
+		{
+			acc0 += load(x+j)*load(h+j);
+			acc1 += load(x+j+V4F_SIZE)*load(h+j+V4F_SIZE);
+		}
+		return sum(acc0+acc1);
+	}
+
+	void Resampler::process(const double* in, size_t n, vector<double>& out)
+	{
+		if(isIdentity())
+		{
+			out.insert(out.end(), in, in+n);
+			return;
+		}
+
+		while(n>0)
+		{
+			size_t nb = min(n, m_buffer.size()-m_size);
+			for(size_t i=0; i<nb; i++)
+				m_buffer[m_size+i] = in[i];
+			m_size += nb;
+			in += nb;
+			n -= nb;
+
+			while(m_pos+m_nb_taps<=m_size)
+			{
+				int p = (m_nb_phases==int(m_L)) ? int(m_frac) : int((unsigned long long)(m_frac)*m_nb_phases/m_L);
+				out.push_back(dot(&m_buffer[m_pos], &m_coefs[p*m_nb_taps]));
+
+				m_frac += m_M;
+				m_pos += m_frac/m_L;
+				m_frac %= m_L;
+			}
+
+			compact();
+		}
+	}
+}
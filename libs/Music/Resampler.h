@@ -0,0 +1,86 @@
+// Copyright 2004 "Gilles Degottex"
+
+// This file is part of "Music"
+
+// "Music" is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 2.1 of the License, or
+// (at your option) any later version.
+// 
+// "Music" is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+
+#ifndef _Resampler_h_
+#define _Resampler_h_
+
+#include <vector>
+using namespace std;
+#include <CppAddons/Simd.h>
+
+namespace Music
+{
+	//! streaming sample rate converter, by a polyphase windowed sinc filter
+	/*!
+	 * The ratio out_rate/in_rate is reduced to L/M; each output sample is the
+	 * dot product of one of the L phases of the filter with the last input
+	 * samples, computed with \ref Simd::v4f. When L is too large (nearly
+	 * coprime rates), the phases are quantised on \ref MAX_PHASES.
+	 * The cutoff is below the lowest of the two Nyquist frequencies, and the
+	 * filter is only as long as needed: the added latency is half of it,
+	 * i.e. zeros*max(1,in_rate/out_rate) input samples.
+	 * With equal rates the samples are passed through, without any latency.
+	 */
+	class Resampler
+	{
+		int m_in_rate;
+		int m_out_rate;
+		int m_zeros;
+
+		unsigned int m_L;		// out_rate/gcd
+		unsigned int m_M;		// in_rate/gcd
+		int m_nb_phases;
+		int m_nb_taps;			// by phase, multiple of V4F_SIZE
+		Simd::vector_f m_coefs;	// m_nb_phases*m_nb_taps
+
+		Simd::vector_f m_buffer;	// the input history
+		size_t m_size;				// used size of m_buffer
+		size_t m_pos;				// first tap of the next output in m_buffer
+		unsigned int m_frac;		// phase of the next output [0;m_L[
+
+		void compact();
+		inline double dot(const float* x, const float* h) const;
+
+	  public:
+		enum {MAX_PHASES=1024};
+
+		//! unique ctor
+		/*!
+		 * \param zeros half length of the filter in zero crossings, the quality
+		 */
+		Resampler(int in_rate=0, int out_rate=0, int zeros=16);
+
+		//! change the rates, forgetting the history
+		void setup(int in_rate, int out_rate, int zeros=16);
+		//! forget the history
+		void reset();
+
+		int getInRate() const				{return m_in_rate;}
+		int getOutRate() const				{return m_out_rate;}
+		bool isIdentity() const				{return m_in_rate==m_out_rate;}
+		//! added latency {input samples}
+		int getLatency() const				{return isIdentity()?0:m_nb_taps/2;}
+
+		//! resample n samples, appending the resulting samples to out
+		void process(const double* in, size_t n, vector<double>& out);
+	};
+}
+
+#endif // _Resampler_h_
@@ -0,0 +1,242 @@
+// Copyright 2004 "Gilles Degottex"
+
+// This file is part of "Music"
+
+// "Music" is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 2.1 of the License, or
+// (at your option) any later version.
+// 
+// "Music" is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+
+#include "SampleFormat.h"
+
+#include <string.h>
+#include <stdint.h>
+#include <ctype.h>
+#include <CppAddons/Simd.h>
+using namespace Simd;
+
+namespace Music
+{
+	typedef int32_t v4i __attribute__((vector_size(16)));
+	typedef int16_t v4s __attribute__((vector_size(8)));
+	typedef uint16_t v4us __attribute__((vector_size(8)));
+	typedef int8_t v4c __attribute__((vector_size(4)));
+	typedef uint8_t v4uc __attribute__((vector_size(4)));
+
+	// the decoders: 4 samples at once (load) or a single one (load1), scaled in [-1;1]
+
+	struct DecodeS8
+	{
+		enum {SIZE=1};
+		static v4f load(const unsigned char* p)		{v4c v; memcpy(&v, p, sizeof(v)); return __builtin_convertvector(v, v4f)*splat(1.0f/128);}
+		static float load1(const unsigned char* p)	{return int8_t(*p)/128.0f;}
+	};
+	struct DecodeU8
+	{
+		enum {SIZE=1};
+		static v4f load(const unsigned char* p)		{v4uc v; memcpy(&v, p, sizeof(v)); return __builtin_convertvector(v, v4f)*splat(1.0f/128)-splat(1.0f);}
+		static float load1(const unsigned char* p)	{return *p/128.0f-1.0f;}
+	};
+	struct DecodeS16
+	{
+		enum {SIZE=2};
+		static v4f load(const unsigned char* p)		{v4s v; memcpy(&v, p, sizeof(v)); return __builtin_convertvector(v, v4f)*splat(1.0f/32768);}
+		static float load1(const unsigned char* p)	{int16_t v; memcpy(&v, p, sizeof(v)); return v/32768.0f;}
+	};
+	struct DecodeU16
+	{
+		enum {SIZE=2};
+		static v4f load(const unsigned char* p)		{v4us v; memcpy(&v, p, sizeof(v)); return __builtin_convertvector(v, v4f)*splat(1.0f/32768)-splat(1.0f);}
+		static float load1(const unsigned char* p)	{uint16_t v; memcpy(&v, p, sizeof(v)); return v/32768.0f-1.0f;}
+	};
+	struct DecodeS24_3
+	{
+		enum {SIZE=3};
+		// little endian 3 bytes, sign extended from the top byte
+		static int32_t get(const unsigned char* p)	{return int32_t(uint32_t(p[0])<<8 | uint32_t(p[1])<<16 | uint32_t(p[2])<<24) >> 8;}
+		static v4f load(const unsigned char* p)		{v4i v = {get(p), get(p+3), get(p+6), get(p+9)}; return __builtin_convertvector(v, v4f)*splat(1.0f/8388608);}
+		static float load1(const unsigned char* p)	{return get(p)/8388608.0f;}
+	};
+	struct DecodeS32
+	{
+		enum {SIZE=4};
+		static v4f load(const unsigned char* p)		{v4i v; memcpy(&v, p, sizeof(v)); return __builtin_convertvector(v, v4f)*splat(1.0f/2147483648.0f);}
+		static float load1(const unsigned char* p)	{int32_t v; memcpy(&v, p, sizeof(v)); return v/2147483648.0f;}
+	};
+	struct DecodeFloat
+	{
+		enum {SIZE=4};
+		static v4f load(const unsigned char* p)		{return Simd::load((const float*)p);}
+		static float load1(const unsigned char* p)	{float v; memcpy(&v, p, sizeof(v)); return v;}
+	};
+
+	// big endian, the bytes are swapped with vector shifts
+	struct DecodeS16BE
+	{
+		enum {SIZE=2};
+		static v4f load(const unsigned char* p)		{v4us v; memcpy(&v, p, sizeof(v)); v = (v<<8)|(v>>8); return __builtin_convertvector((v4s)v, v4f)*splat(1.0f/32768);}
+		static float load1(const unsigned char* p)	{return int16_t(uint16_t(p[0])<<8 | p[1])/32768.0f;}
+	};
+	struct DecodeFloatBE
+	{
+		enum {SIZE=4};
+		typedef uint32_t v4ui __attribute__((vector_size(16)));
+		static v4f load(const unsigned char* p)
+		{
+			v4ui v; memcpy(&v, p, sizeof(v));
+			v = (v<<24) | ((v<<8)&0x00ff0000) | ((v>>8)&0x0000ff00) | (v>>24);
+			return (v4f)v;
+		}
+		static float load1(const unsigned char* p)
+		{
+			uint32_t v = uint32_t(p[0])<<24 | uint32_t(p[1])<<16 | uint32_t(p[2])<<8 | p[3];
+			float f; memcpy(&f, &v, sizeof(f)); return f;
+		}
+	};
+
+	template<typename D>
+	void ConvertMono(const void* in, size_t nb_frames, int, float* out)
+	{
+		const unsigned char* p = (const unsigned char*)in;
+		size_t i=0;
+		for(; i+V4F_SIZE<=nb_frames; i+=V4F_SIZE)
+			store(out+i, D::load(p+i*D::SIZE));
+		for(; i<nb_frames; i++)
+			out[i] = D::load1(p+i*D::SIZE);
+	}
+
+	template<typename D>
+	void ConvertStereo(const void* in, size_t nb_frames, int, float* out)
+	{
+		const unsigned char* p = (const unsigned char*)in;
+		size_t i=0;
+		for(; i+V4F_SIZE<=nb_frames; i+=V4F_SIZE)
+		{
+			v4f a = D::load(p+2*i*D::SIZE);					// l0 r0 l1 r1
+			v4f b = D::load(p+(2*i+V4F_SIZE)*D::SIZE);		// l2 r2 l3 r3
+			v4f m = {a[0]+a[1], a[2]+a[3], b[0]+b[1], b[2]+b[3]};
+			store(out+i, m*splat(0.5f));
+		}
+		for(; i<nb_frames; i++)
+			out[i] = 0.5f*(D::load1(p+2*i*D::SIZE) + D::load1(p+(2*i+1)*D::SIZE));
+	}
+
+	template<typename D>
+	void ConvertChannels(const void* in, size_t nb_frames, int nb_channels, float* out)
+	{
+		const unsigned char* p = (const unsigned char*)in;
+		float scale = 1.0f/nb_channels;
+		for(size_t i=0; i<nb_frames; i++)
+		{
+			float sum = 0.0f;
+			for(int c=0; c<nb_channels; c++)
+				sum += D::load1(p+(i*nb_channels+c)*D::SIZE);
+			out[i] = scale*sum;
+		}
+	}
+
+	template<typename D>
+	SampleConverter GetConverter(int nb_channels)
+	{
+		if(nb_channels==1)		return ConvertMono<D>;
+		else if(nb_channels==2)	return ConvertStereo<D>;
+		else					return ConvertChannels<D>;
+	}
+
+	int GetSampleSize(SampleFormat format)
+	{
+		switch(format)
+		{
+		case SAMPLE_S8:		return DecodeS8::SIZE;
+		case SAMPLE_U8:		return DecodeU8::SIZE;
+		case SAMPLE_S16:	return DecodeS16::SIZE;
+		case SAMPLE_U16:	return DecodeU16::SIZE;
+		case SAMPLE_S24_3:	return DecodeS24_3::SIZE;
+		case SAMPLE_S32:	return DecodeS32::SIZE;
+		case SAMPLE_FLOAT:	return DecodeFloat::SIZE;
+		case SAMPLE_S16_BE:	return DecodeS16BE::SIZE;
+		case SAMPLE_FLOAT_BE:	return DecodeFloatBE::SIZE;
+		default:			return 0;
+		}
+	}
+
+	const char* GetSampleFormatName(SampleFormat format)
+	{
+		switch(format)
+		{
+		case SAMPLE_S8:		return "S8";
+		case SAMPLE_U8:		return "U8";
+		case SAMPLE_S16:	return "S16";
+		case SAMPLE_U16:	return "U16";
+		case SAMPLE_S24_3:	return "S24_3LE";
+		case SAMPLE_S32:	return "S32";
+		case SAMPLE_FLOAT:	return "FLOAT";
+		case SAMPLE_S16_BE:	return "S16_BE";
+		case SAMPLE_FLOAT_BE:	return "FLOAT_BE";
+		default:			return "unknown";
+		}
+	}
+
+	SampleFormat FindSampleFormat(const std::string& name)
+	{
+		std::string n;
+		for(size_t i=0; i<name.size(); i++)
+			if(name[i]!='_')
+				n += char(tolower(name[i]));
+		// the little endian suffix is the native order of the kernels
+		bool big_endian = false;
+		if(n.size()>2 && n.compare(n.size()-2, 2, "le")==0)
+			n.erase(n.size()-2);
+		else if(n.size()>2 && n.compare(n.size()-2, 2, "be")==0)
+		{
+			n.erase(n.size()-2);
+			big_endian = true;
+		}
+
+		if(n=="l16")					return SAMPLE_S16_BE;
+		if(big_endian)
+		{
+			if(n=="s16")				return SAMPLE_S16_BE;
+			if(n=="f32" || n=="float")	return SAMPLE_FLOAT_BE;
+			return SAMPLE_UNKNOWN;
+		}
+
+		if(n=="s8")						return SAMPLE_S8;
+		if(n=="u8")						return SAMPLE_U8;
+		if(n=="s16")					return SAMPLE_S16;
+		if(n=="u16")					return SAMPLE_U16;
+		if(n=="s243")					return SAMPLE_S24_3;
+		if(n=="s32")					return SAMPLE_S32;
+		if(n=="f32" || n=="float")		return SAMPLE_FLOAT;
+
+		return SAMPLE_UNKNOWN;
+	}
+
+	SampleConverter GetSampleConverter(SampleFormat format, int nb_channels)
+	{
+		switch(format)
+		{
+		case SAMPLE_S8:		return GetConverter<DecodeS8>(nb_channels);
+		case SAMPLE_U8:		return GetConverter<DecodeU8>(nb_channels);
+		case SAMPLE_S16:	return GetConverter<DecodeS16>(nb_channels);
+		case SAMPLE_U16:	return GetConverter<DecodeU16>(nb_channels);
+		case SAMPLE_S24_3:	return GetConverter<DecodeS24_3>(nb_channels);
+		case SAMPLE_S32:	return GetConverter<DecodeS32>(nb_channels);
+		case SAMPLE_FLOAT:	return GetConverter<DecodeFloat>(nb_channels);
+		case SAMPLE_S16_BE:	return GetConverter<DecodeS16BE>(nb_channels);
+		case SAMPLE_FLOAT_BE:	return GetConverter<DecodeFloatBE>(nb_channels);
+		default:			return NULL;
+		}
+	}
+}
@@ -0,0 +1,57 @@
+// Copyright 2004 "Gilles Degottex"
+
+// This file is part of "Music"
+
+// "Music" is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 2.1 of the License, or
+// (at your option) any later version.
+// 
+// "Music" is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+
+#ifndef _SampleFormat_h_
+#define _SampleFormat_h_
+
+#include <stddef.h>
+#include <string>
+
+namespace Music
+{
+	//! the PCM formats of the captured samples, in the native byte order (but S24_3 always little endian)
+	/*!
+	 * The _BE ones are big endian, the network order of the RTP payloads (L16).
+	 */
+	enum SampleFormat{SAMPLE_S8, SAMPLE_U8, SAMPLE_S16, SAMPLE_U16, SAMPLE_S24_3, SAMPLE_S32, SAMPLE_FLOAT, SAMPLE_S16_BE, SAMPLE_FLOAT_BE, SAMPLE_UNKNOWN};
+
+	//! bytes by sample
+	int GetSampleSize(SampleFormat format);
+	const char* GetSampleFormatName(SampleFormat format);
+	//! the format of a name, case insensitive, with or without the byte order and underscores (S16_LE, s16le, f32le, float, s16be, L16, ...)
+	SampleFormat FindSampleFormat(const std::string& name);
+
+	//! convert interleaved frames to mono samples in [-1;1], averaging the channels
+	/*!
+	 * \param in nb_frames*nb_channels samples
+	 * \param out nb_frames samples
+	 */
+	typedef void (*SampleConverter)(const void* in, size_t nb_frames, int nb_channels, float* out);
+
+	//! the block kernel for a format, to get once at setup
+	/*!
+	 * The kernels process the samples 4 by 4 with \ref Simd::v4f, mono and
+	 * stereo have their own kernels, the other channel counts a generic one.
+	 * \return NULL for SAMPLE_UNKNOWN
+	 */
+	SampleConverter GetSampleConverter(SampleFormat format, int nb_channels);
+}
+
+#endif // _SampleFormat_h_
@@ -31,65 +31,129 @@ using namespace std;
 #include <CppAddons/Random.h>
 
 #include "Music.h"
+#include "Oscillator.h"
 
 namespace Music
 {
 
-void GenerateScore(	vector<double>& buffer,			// the score's wav
-				vector< vector<int> >& score,	// the score
-				double lenght,					// lenght of the score in seconds	: R+*
-				int dataBySecond,				// number of data by second			: ~{11000, 22000, 44100}
-				double AFreq,					// frequency of A					: ~440.0
-				int minHT,						// minimum halftone					: Z		// TODO <0
-				int maxHT,						// maximum halftone					: Z
-				int nbNotes,					// number of notes in lenght		: N*
-				int nbVoice)					// number of voices					: N*
+int GetSingleNote(const vector<ScoreEvent>& score, size_t from, size_t to)
 {
-	static Random rdm;
+	// first note ending after from
+	size_t lo=0, hi=score.size();
+	while(lo<hi)
+	{
+		size_t mid = (lo+hi)/2;
+		if(score[mid].end<=from)	lo = mid+1;
+		else						hi = mid;
+	}
+
+	int ht = UNDEFINED_SEMITONE;
+	int count = 0;
+	for(size_t i=lo; i<score.size() && score[i].start<to; i++)
+	{
+		if(score[i].start>from || score[i].end<to)
+			return UNDEFINED_SEMITONE;	// doesn't cover the whole range
+
+		ht = score[i].ht;
+		count++;
+	}
+
+	return (count==1)?ht:UNDEFINED_SEMITONE;
+}
 
+void GenerateScoreFromInstruments(
+		vector<double>& buffer,
+		vector<ScoreEvent>& score,
+		vector<Instrument*>& instrs,
+		double lenght,
+		int dataBySecond,
+		double AFreq,
+		int minHT,
+		int maxHT,
+		int nbNotes,
+		int nbInstr)
+{
 	int size = int(lenght*dataBySecond);
-	int nbHT = maxHT-minHT+1;
 	int note_size = size / nbNotes;
-	cout << "AFreq=" << AFreq << " dataBySecond=" << dataBySecond << endl;
-	cout << "nbNotes=" << nbNotes << " lenght=" << lenght << " minHT=" << minHT << " maxHT=" << maxHT << endl;
-	cout << "size=" << size << " nbHT=" << nbHT << " nbVoice=" << nbVoice << endl;
 
-	cout << "make score ... \t\t" << flush;
-//	int n=0;
+	// TODO compute up so every harm are present in the range of minHT maxHT
+	int up = 36;
+
+	assert((size_t)nbInstr<=instrs.size());
+
+	size_t t = buffer.size();
+	buffer.resize(t+nbNotes*note_size);
+	score.reserve(score.size()+nbNotes*nbInstr);
+
 	for(int i=0; i<nbNotes; i++)
 	{
-		vector<int> hs(nbVoice);
-		for(size_t v=0; v<hs.size(); v++)
-			hs[v] = minHT+rdm.nextInt(maxHT-minHT+1);
-
-//		cout << "halftone selected=" << h << " freq=" << freq << endl;
-		for(int j=0; j<note_size; j++)
+		vector<int> hs(instrs.size());
+		vector< Math::polar<double> > ps(instrs.size());
+		vector<bool> play(instrs.size());
+		for(size_t w=0; w<play.size(); w++)	play[w] = false;
+		int count_playing=0;
+		while(count_playing<nbInstr)
 		{
-			double buff = 0.0;
-			for(size_t v=0; v<hs.size(); v++)
-				buff += sin( ((2.0*Math::Pi)/dataBySecond)*h2f(hs[v], AFreq)*double(j) );
-
-//			int index = i*note_size+j;
-			// add data index and wav value
-	
-			buffer.push_back(buff);
-			// add score halftones (solution)
-			vector<int> score_at(nbHT);
-			for(int vh=0; vh<nbHT; vh++)
+			int index = int(Random::s_random.nextDouble()*play.size());
+			if(!play[index])
 			{
-				int ampl = 0;
-				for(size_t v=0; v<hs.size(); v++)
-					if(hs[v]==vh+minHT)
-						ampl++;
-				score_at[vh] = ampl;
+				play[index] = true;
+				count_playing++;
 			}
-			score.push_back(score_at);
-//			n = undoable_out_percent(cout, 100.0f*index/size, n);
 		}
+		for(size_t v=0; v<hs.size(); v++)
+		{
+			hs[v] = minHT+Random::s_random.nextInt(maxHT-minHT-up+1);
+			ps[v] = Math::polar<double>(Random::s_random.nextDouble()/nbInstr, Random::s_random.nextDouble()*2*Math::Pi);
+		}
+
+		for(size_t v=0; v<instrs.size(); v++)
+			if(play[v])
+				instrs[v]->gen_values(hs[v], ps[v].arg, ps[v].mod, &buffer[t], note_size);
+
+		for(size_t v=0; v<instrs.size(); v++)
+			if(play[v] && ps[v].mod>0.05)					  // TODO 0.1: note is here if we hear it !
+				score.push_back(ScoreEvent(t, t+note_size, hs[v], ps[v].mod));
+
+		t += note_size;
 	}
-//	undoable_out_clear(cout, n);
-	cout << "done   " << endl;
 }
 
+void GenerateScore(	vector<double>& buffer,
+		vector<ScoreEvent>& score,
+		double lenght,
+		int dataBySecond,
+		double AFreq,
+		int minHT,
+		int maxHT,
+		int nbNotes,
+		int nbVoice)
+{
+	int size = int(lenght*dataBySecond);
+	int note_size = size / nbNotes;
+
+	size_t t = buffer.size();
+	buffer.resize(t+nbNotes*note_size);
+	score.reserve(score.size()+nbNotes*nbVoice);
+
+	OscillatorBank bank(nbVoice);
+
+	for(int i=0; i<nbNotes; i++)
+	{
+		vector<int> hs(nbVoice);
+		for(size_t v=0; v<hs.size(); v++)
+			hs[v] = minHT+Random::s_random.nextInt(maxHT-minHT+1);
+
+		for(size_t v=0; v<hs.size(); v++)
+			bank.set(v, 1.0, ((2.0*Math::Pi)/dataBySecond)*h2f(hs[v], AFreq), Random::s_random.nextDouble()*Math::Pi/2);
+
+		bank.generate(&buffer[t], note_size);
+
+		for(size_t v=0; v<hs.size(); v++)
+			score.push_back(ScoreEvent(t, t+note_size, hs[v], 1.0));
+
+		t += note_size;
+	}
 }
 
+}
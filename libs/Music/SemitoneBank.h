@@ -0,0 +1,118 @@
+// Copyright 2004 "Gilles Degottex"
+
+// This file is part of "Music"
+
+// "Music" is free software; you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 2.1 of the License, or
+// (at your option) any later version.
+//
+// "Music" is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+#ifndef _SemitoneBank_h_
+#define _SemitoneBank_h_
+
+#include <vector>
+#include <memory>
+#include <atomic>
+using namespace std;
+#include "Music.h"
+
+namespace Music
+{
+	//! one object by analysed semi-tone, rebuilt on settings changes without stalling the analysis
+	/*!
+	 * \ref build runs in the thread changing the settings (the \ref SettingsListener
+	 * callbacks): it creates the objects for the new settings, reusing the
+	 * previous ones which still match (same sampling rate, same A3 and
+	 * accepted by the caller), then publishes them.
+	 * \ref adopt runs in the analysis thread, at a frame boundary: it only
+	 * swaps a pointer when new objects are published.
+	 * The objects are shared between the successive sets, so an object is
+	 * deleted with the last set using it.
+	 */
+	template<typename T>
+	class SemitoneBank
+	{
+		struct Set
+		{
+			int sampling_rate;
+			double AFreq;
+			int semitone_min;
+			vector< shared_ptr<T> > objs;
+		};
+
+		shared_ptr<Set> m_built;		// the last built set, building thread only
+		atomic<Set*> m_pending;			// published, not yet adopted
+		shared_ptr<Set> m_current;		// analysis thread only
+
+		SemitoneBank(const SemitoneBank&);
+		SemitoneBank& operator=(const SemitoneBank&);
+
+	  public:
+		SemitoneBank() : m_pending(NULL)	{}
+
+		//! build the objects for the semi-tones [GetSemitoneMin();GetSemitoneMax()]
+		/*!
+		 * \param create T* create(int ht) creates a new object
+		 * \param match bool match(const T&) is true if the object can be kept
+		 */
+		template<typename Create, typename Match>
+		void build(Create create, Match match)
+		{
+			shared_ptr<Set> set(new Set());
+			set->sampling_rate = GetSamplingRate();
+			set->AFreq = GetAFreq();
+			set->semitone_min = GetSemitoneMin();
+			set->objs.resize(GetNbSemitones());
+
+			bool reuse = m_built && m_built->sampling_rate==set->sampling_rate && m_built->AFreq==set->AFreq;
+			for(int h=0; h<int(set->objs.size()); h++)
+			{
+				int old_h = h+set->semitone_min-(reuse?m_built->semitone_min:0);
+				if(reuse && old_h>=0 && old_h<int(m_built->objs.size()) && match(*m_built->objs[old_h]))
+					set->objs[h] = m_built->objs[old_h];
+				else
+					set->objs[h] = shared_ptr<T>(create(h+set->semitone_min));
+			}
+
+			m_built = set;
+			delete m_pending.exchange(new Set(*set), memory_order_acq_rel);
+		}
+
+		//! make the last built objects the current ones
+		/*!
+		 * \param objs filled with the current objects, indexed from GetSemitoneMin()
+		 * \return true if objs changed
+		 */
+		bool adopt(vector<T*>& objs)
+		{
+			if(m_pending.load(memory_order_relaxed)==NULL)	return false;
+
+			Set* set = m_pending.exchange(NULL, memory_order_acq_rel);
+			if(set==NULL)	return false;
+
+			m_current.reset(set);
+			objs.resize(set->objs.size());
+			for(size_t h=0; h<objs.size(); h++)
+				objs[h] = set->objs[h].get();
+
+			return true;
+		}
+
+		~SemitoneBank()
+		{
+			delete m_pending.load();
+		}
+	};
+}
+
+#endif // _SemitoneBank_h_
@@ -39,6 +39,8 @@ using namespace Math;
 
 namespace Music
 {
+	static const double s_semitone_up = pow(2.0, 1.0/12.0);
+
 	double InterpolatedWaveLength(const std::deque<double>& queue, int left, int right)
 	{
 		double l = left - queue[left]/(queue[left+1]-queue[left]);
@@ -61,23 +63,30 @@ namespace Music
 	 *	(souvient plus du nom, demander à Jan))
 	 */
 	double GetAverageWaveLengthFromApprox(const std::deque<double>& queue, size_t approx, int n, double AFreq, int sampling_rate)
+	{
+		Frame frame(queue);
+		return GetAverageWaveLengthFromApprox(frame, approx, n, AFreq, sampling_rate);
+	}
+	double GetAverageWaveLengthFromApprox(const Frame& frame, size_t approx, int n, double AFreq, int sampling_rate)
 	{
 		if(AFreq!=0.0f)		assert(sampling_rate>0);
 
+		const std::deque<double>& queue = frame.getBuffer();
+
 		double wave_length = 0.0f;
 		if(queue.size()<2)	return 0.0f;
 
-		deque<int> ups;									// the upper peeks
-
-		// parse the whole buffer, for n zeros
-		for(int i=0; int(ups.size())<n && i+1<int(queue.size()); i++)
-			if(queue[i]<=0 && queue[i+1]>0)				// if it cross the axis
-				ups.push_back(i);
+		// the upper peeks: the first n zeros crossing the axis
+		vector<size_t> ups = frame.upCrossings(size_t(max(n, 0)));
 
 		if(ups.size()<1)	return 0.0f;
 
 		int count = 0;
 
+		// sampling_rate/h2f(f2hf(sampling_rate/approx)+-1) is approx*2^(-+1/12)
+		int low_bound = int(approx/s_semitone_up);
+		int high_bound = int(approx*s_semitone_up);
+
 //		cerr << "approx=" << approx << " wave_length=(";
 		for(int i=0; i<int(ups.size()); i++)
 		{
@@ -104,12 +113,7 @@ namespace Music
 
 				bool ok=true;
 				if(AFreq!=0.0f)
-				{
-					double ht = f2hf(double(sampling_rate)/approx, AFreq);
-					int low_bound = int(sampling_rate/h2f(ht+1, AFreq));
-					int high_bound = int(sampling_rate/h2f(ht-1, AFreq));
-					ok = i_seek>ups[i]+low_bound && i_seek<ups[i]+high_bound;
-				}
+					ok = i_seek>int(ups[i])+low_bound && i_seek<int(ups[i])+high_bound;
 				if(ok)
 				{
 //					cerr << "["<<ups[i]<<"{"<<low_bound<<"<"<<lower_i_seek-ups[i]<<","<<higher_i_seek-ups[i]<<"<"<<high_bound<<"}"<< i_seek - ups[i] << "] ";
@@ -33,6 +33,8 @@ namespace Music
 {
 	//! Seek for the period (relative to sampling rate)
 	double GetAverageWaveLengthFromApprox(const std::deque<double>& queue, size_t approx, int n, double AFreq=GetAFreq(), int sampling_rate=GetSamplingRate());
+	//! same as above, with the zero crossings of the frame
+	double GetAverageWaveLengthFromApprox(const Frame& frame, size_t approx, int n, double AFreq=GetAFreq(), int sampling_rate=GetSamplingRate());
 
 	//! Get a sample of the wave form (relative to sampling rate)
 	void GetWaveSample(const std::deque<double>& queue, size_t wave_length, std::deque<double>& sample);
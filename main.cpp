@@ -1,22 +1,103 @@
 #include <iostream>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
 
 #include <Music/Music.h>
+#include <CppAddons/RealTime.h>
 #include "ANR.h"
 #include "CustomMainForm.h"
 
 using namespace std;
 
+static void select_transport(const char* name, const char* source)
+{
+	try
+	{
+		anr().m_capture_thread.selectTransport(name);
+		anr().m_capture_thread.setSource(source);
+	}
+	catch(QString error)
+	{
+		cerr << error.toStdString() << endl;
+	}
+}
+
 int main (int argc, char *argv[])
 {
 	QApplication app(argc, argv);
 	CustomMainForm win;
 
-	Music::SetSamplingRate(44100);
+	// the analysis rate, the captured samples are resampled to it (22050 is enough for a guitar)
+	int analysis_rate = 44100;
+	if(getenv("COUCHER_ANALYSIS_RATE")!=NULL && atoi(getenv("COUCHER_ANALYSIS_RATE"))>0)
+		analysis_rate = atoi(getenv("COUCHER_ANALYSIS_RATE"));
+	Music::SetSamplingRate(analysis_rate);
+
+	// stage timings of the recognition, dumped on SIGUSR1 and at exit
+	if(getenv("COUCHER_STATS")!=NULL)
+	{
+		Histogram::setEnabled(true);
+		Histogram::installDump(SIGUSR1);
+	}
 
 	new ANR();
 	anr().init();
 
+	// MultiCorr and AutoCorr running in parallel and voting
+	if(getenv("COUCHER_ENSEMBLE")!=NULL)
+		anr().setEnsemble(true);
+
+	// restrict the analysis to an instrument range (guitar, guitar7, bass, voice)
+	if(getenv("COUCHER_INSTRUMENT")!=NULL)
+	{
+		const Music::InstrumentProfile* profile = Music::FindInstrumentProfile(getenv("COUCHER_INSTRUMENT"));
+		if(profile!=NULL)
+			anr().setInstrumentProfile(*profile);
+		else
+			cerr << "unknown instrument profile " << getenv("COUCHER_INSTRUMENT") << endl;
+	}
+
+	// real-time mode: SCHED_FIFO priority of the capture thread (the analysis
+	// thread gets the one below), optionally pinned on "capture_cpu,analysis_cpu"
+	if(getenv("COUCHER_REALTIME")!=NULL)
+	{
+		int priority = atoi(getenv("COUCHER_REALTIME"));
+		if(priority<2)	priority = 70;
+
+		int capture_cpu = -1;
+		int analysis_cpu = -1;
+		if(getenv("COUCHER_CPUS")!=NULL)
+			sscanf(getenv("COUCHER_CPUS"), "%d,%d", &capture_cpu, &analysis_cpu);
+
+		anr().m_capture_thread.setRealTime(priority, capture_cpu);
+		anr().m_analysis_thread.setRealTime(priority-1, analysis_cpu);
+
+		if(!RealTime::lockMemory())
+			cerr << "cannot lock the memory: " << strerror(errno) << endl;
+	}
+
+	// what to do when the analysis can't keep up: drop_oldest (default), drop_newest, block (sound files only)
+	if(getenv("COUCHER_OVERRUN")!=NULL)
+	{
+		string policy = getenv("COUCHER_OVERRUN");
+		if(policy=="drop_oldest")		anr().m_capture_thread.setOverrunPolicy(CaptureThread::DROP_OLDEST);
+		else if(policy=="drop_newest")	anr().m_capture_thread.setOverrunPolicy(CaptureThread::DROP_NEWEST);
+		else if(policy=="block")		anr().m_capture_thread.setOverrunPolicy(CaptureThread::BLOCK);
+		else							cerr << "unknown overrun policy " << policy << endl;
+	}
+
 	anr().m_capture_thread.autoDetectTransport();
+
+	// raw PCM from stdin or a named pipe: "<path>[:<format>[:<rate>[:<channels>[:offline]]]]"
+	if(getenv("COUCHER_PIPE")!=NULL)
+		select_transport("PIPE", getenv("COUCHER_PIPE"));
+
+	// RTP packets on a local port: "[<address>:]<port>[:<format>[:<rate>[:<channels>]]]"
+	if(getenv("COUCHER_RTP")!=NULL)
+		select_transport("RTP", getenv("COUCHER_RTP"));
 	//anr().m_capture_thread.selectTransport("SOUNDFILE");
 
 	anr().start();